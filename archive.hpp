@@ -0,0 +1,432 @@
+#ifndef archive_hpp_20201024_143112_PDT
+#define archive_hpp_20201024_143112_PDT
+
+#include "protocol.hpp"
+#include <cpp/type_traits.hpp>
+#include <cpp/cpp.hpp>
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace tpl
+{
+/*********************************************************************************************************************
+* Archive file format.
+*
+*   [header]   8-byte magic "TPLARC\0\1"
+*   [blocks]   length-prefixed messages (see `framed_definition`), in the order written, cut into blocks of about
+*              `block_size` bytes at frame boundaries
+*   [index]    block offsets and the sequence number of each block's first message, as `std::vector<uint64_t>`
+*              fields; then the IDs of the message types present, as a `std::vector<uint8_t>` field, and for each
+*              one, the numbers of the blocks in which it occurs, as a `std::vector<uint32_t>` field
+*   [trailer]  index offset and message count as `uint64_t` fields, then the 8-byte magic "TPLAIDX\1"
+*
+* All integers are little-endian, as encoded by `Field`.  The index is per block rather than per message, so that it
+* stays small and the writer's memory stays bounded no matter how long the recording; finding a given message in a
+* block then means hopping over the frames before it, which reads only their headers.
+*********************************************************************************************************************/
+  namespace detail {
+
+      struct archive_format
+      {
+        static constexpr size_t header_size  = 8;
+        static constexpr size_t trailer_size = 24;
+
+        static auto header_magic() -> const char* { return "TPLARC\0\1"; }
+        static auto trailer_magic() -> const char* { return "TPLAIDX\1"; }
+      };
+
+      inline auto throw_errno(const char* what) -> void
+        {
+          throw std::system_error(errno, std::generic_category(), what);
+        }
+  } /* namespace detail */
+
+  /*!
+   * \brief Writes messages of a `framed_definition` to an archive file (see above), to be read by `archive_reader`.
+   *
+   *        Messages are buffered a block at a time; the index is written by `close`, or by the destructor, which
+   *        swallows any error in doing so.
+   */
+  template<typename DefinitionT>
+  class archive_writer
+  {
+    static_assert(cpp::is_same<typename DefinitionT::framing_type, framing::length_prefixed>::value, "Archives store length-prefixed messages; use a framed_definition.");
+  public:
+    explicit archive_writer(const cpp::string& path, size_t block_size = 64 * 1024)
+      : block_size_(block_size)
+      {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if(fd_ < 0)
+        {
+          detail::throw_errno("cannot create archive");
+        }
+        try
+        {
+          write_out(detail::archive_format::header_magic(), detail::archive_format::header_size);
+        }
+        catch(...)
+        {
+          ::close(fd_);
+          throw;
+        }
+      }
+    ~archive_writer()
+      {
+        if(fd_ >= 0)
+        {
+          try
+          {
+            close();
+          }
+          catch(...)
+          {}
+        }
+      }
+    archive_writer(const archive_writer&) = delete;
+    auto operator=(const archive_writer&) -> archive_writer& = delete;
+
+    /*!
+     * \brief Appends `m` to the archive, as message number `message_count()`.
+     */
+    template<typename MessageT>
+    auto write(const MessageT& m) -> void
+      {
+        if(fd_ < 0)
+        {
+          throw std::logic_error("write to closed archive");
+        }
+        auto size = DefinitionT::serialized_size(m);
+        if(!block_.empty() && block_.size() + size > block_size_)
+        {
+          flush_block();
+        }
+        if(block_.empty())
+        {
+          block_offsets_.push_back(offset_);
+          block_sequences_.push_back(message_count_);
+          block_types_.reset();
+        }
+        DefinitionT::serialize(m, block_);
+        block_types_.set(static_cast<unsigned char>(MessageT::message_type_id()));
+        ++message_count_;
+      }
+    auto message_count() const -> uint64_t { return message_count_; }
+
+    /*!
+     * \brief Writes the last block, the index and the trailer, and closes the file.
+     */
+    auto close() -> void
+      {
+        if(fd_ < 0)
+        {
+          return;
+        }
+        flush_block();
+        auto index_offset = offset_;
+        cpp::string index;
+        Field<std::vector<uint64_t>>::serialize(index, block_offsets_);
+        Field<std::vector<uint64_t>>::serialize(index, block_sequences_);
+        std::vector<uint8_t> ids;
+        for(size_t id = 0; id < type_blocks_.size(); ++id)
+        {
+          if(!type_blocks_[id].empty())
+          {
+            ids.push_back(static_cast<uint8_t>(id));
+          }
+        }
+        Field<std::vector<uint8_t>>::serialize(index, ids);
+        for(auto id : ids)
+        {
+          Field<std::vector<uint32_t>>::serialize(index, type_blocks_[id]);
+        }
+        Field<uint64_t>::serialize(index, index_offset);
+        Field<uint64_t>::serialize(index, message_count_);
+        index.append(detail::archive_format::trailer_magic(), 8);
+        write_out(index.data(), index.size());
+        auto fd = fd_;
+        fd_ = -1;
+        if(::close(fd) != 0)
+        {
+          detail::throw_errno("cannot close archive");
+        }
+      }
+  private:
+    auto flush_block() -> void
+      {
+        if(block_.empty())
+        {
+          return;
+        }
+        auto block = static_cast<uint32_t>(block_offsets_.size() - 1);
+        for(size_t id = 0; id < type_blocks_.size(); ++id)
+        {
+          if(block_types_[id])
+          {
+            type_blocks_[id].push_back(block);
+          }
+        }
+        write_out(block_.data(), block_.size());
+        block_.clear();
+      }
+    auto write_out(const char* data, size_t size) -> void
+      {
+        while(size != 0)
+        {
+          auto n = ::write(fd_, data, size);
+          if(n < 0)
+          {
+            if(errno == EINTR)
+            {
+              continue;
+            }
+            detail::throw_errno("cannot write archive");
+          }
+          data    += n;
+          size    -= static_cast<size_t>(n);
+          offset_ += static_cast<uint64_t>(n);
+        }
+      }
+
+    int                                    fd_            = -1;
+    size_t                                 block_size_;
+    uint64_t                               offset_        = 0;
+    uint64_t                               message_count_ = 0;
+    cpp::string                            block_;
+    std::bitset<256>                       block_types_;
+    std::vector<uint64_t>                  block_offsets_;
+    std::vector<uint64_t>                  block_sequences_;
+    std::array<std::vector<uint32_t>, 256> type_blocks_;
+  };
+
+  /*!
+   * \brief Reads an archive written by `archive_writer`, which it maps into memory; messages are decoded straight
+   *        from the mapping, so `string_ref` fields remain valid for the lifetime of the reader.
+   *
+   *        Besides visiting every message, the reader can visit just the messages of one type--decoding nothing
+   *        else, and reading only the blocks which contain that type--or find a message by its sequence number.
+   */
+  template<typename DefinitionT>
+  class archive_reader
+  {
+    static_assert(cpp::is_same<typename DefinitionT::framing_type, framing::length_prefixed>::value, "Archives store length-prefixed messages; use a framed_definition.");
+
+    using framer_type = detail::framer<framing::length_prefixed>;
+  public:
+    explicit archive_reader(const cpp::string& path)
+      {
+        auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+          detail::throw_errno("cannot open archive");
+        }
+        struct stat status;
+        if(::fstat(fd, &status) != 0)
+        {
+          ::close(fd);
+          detail::throw_errno("cannot open archive");
+        }
+        size_ = static_cast<size_t>(status.st_size);
+        if(size_ < detail::archive_format::header_size + detail::archive_format::trailer_size)
+        {
+          ::close(fd);
+          throw std::runtime_error("not a templar archive");
+        }
+        auto mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(mapping == MAP_FAILED)
+        {
+          detail::throw_errno("cannot map archive");
+        }
+        file_ = static_cast<const char*>(mapping);
+        try
+        {
+          read_index();
+        }
+        catch(...)
+        {
+          ::munmap(const_cast<char*>(file_), size_);
+          throw;
+        }
+      }
+    ~archive_reader()
+      {
+        ::munmap(const_cast<char*>(file_), size_);
+      }
+    archive_reader(const archive_reader&) = delete;
+    auto operator=(const archive_reader&) -> archive_reader& = delete;
+
+    auto message_count() const -> uint64_t { return message_count_; }
+    auto block_count() const -> size_t { return block_offsets_.size(); }
+
+    /*!
+     * \brief The messages, as one buffer of `size()` bytes which can be passed to a visitor or `dispatch`.
+     */
+    auto data() const -> const char* { return file_ + detail::archive_format::header_size; }
+    auto size() const -> size_t { return static_cast<size_t>(index_offset_) - detail::archive_format::header_size; }
+
+    /*!
+     * \brief The offsets of the blocks within `data()`, followed by `size()`: chunk boundaries for `parallel_decoder`
+     *        which need no scan.
+     */
+    auto boundaries() const -> std::vector<size_t>
+      {
+        std::vector<size_t> result { 0 };
+        for(size_t block = 1; block < block_offsets_.size(); ++block)
+        {
+          result.push_back(static_cast<size_t>(block_offsets_[block]) - detail::archive_format::header_size);
+        }
+        result.push_back(size());
+        return result;
+      }
+
+    /*!
+     * \brief Visits every message in the archive, in order.
+     */
+    auto accept(typename DefinitionT::visitor& visitor) const -> void
+      {
+        visitor.accept(data(), size());
+      }
+    template<typename HandlerT>
+    auto dispatch(HandlerT&& handler) const -> void
+      {
+        DefinitionT::dispatch(data(), size(), handler);
+      }
+
+    /*!
+     * \brief Passes each message of type `MessageT` to `handler`, in order, without decoding any other message.
+     */
+    template<typename MessageT, typename HandlerT>
+    auto visit_all(HandlerT&& handler) const -> void
+      {
+        static_assert(cpp::is_same<detail::matching_message_type_from<static_cast<size_t>(MessageT::message_type_id()), typename DefinitionT::message_tuple_type>, MessageT>::value, "Message type is not part of this protocol definition.");
+        auto id = static_cast<unsigned char>(MessageT::message_type_id());
+        for(auto block : type_blocks_[id])
+        {
+          auto begin = file_ + block_offsets_[block];
+          auto end   = file_ + block_end(block);
+          while(begin < end)
+          {
+            auto frame_id = static_cast<unsigned char>(*begin);
+            auto body_end = framer_type::read_header(begin, end);
+            if(frame_id == id)
+            {
+              auto body = begin;
+              handler(MessageT { detail::MessageDeserializer<0, typename MessageT::field_tuple_type>::deserialize(body, body_end) });
+            }
+            begin = body_end;
+          }
+        }
+      }
+
+    /*!
+     * \brief The encoded frame of message number `n`, which `DefinitionT::dispatch` or a visitor can decode, found
+     *        by hopping over the frames before it in its block.
+     */
+    auto seek(uint64_t n) const -> string_ref
+      {
+        if(n >= message_count_)
+        {
+          throw std::out_of_range("archive message number out of range");
+        }
+        auto block = static_cast<size_t>(std::upper_bound(block_sequences_.begin(), block_sequences_.end(), n) - block_sequences_.begin()) - 1;
+        auto begin = file_ + block_offsets_[block];
+        auto end   = file_ + block_end(block);
+        for(auto i = block_sequences_[block]; i < n; ++i)
+        {
+          skip_frame(begin, end);
+        }
+        auto frame = begin;
+        skip_frame(begin, end);
+        return string_ref(frame, static_cast<size_t>(begin - frame));
+      }
+    /*!
+     * \brief Decodes message number `n` and passes it to `handler`; see `DefinitionT::dispatch`.
+     */
+    template<typename HandlerT>
+    auto read(uint64_t n, HandlerT&& handler) const -> void
+      {
+        auto frame = seek(n);
+        DefinitionT::dispatch(frame.data(), frame.size(), handler);
+      }
+  private:
+    static auto skip_frame(const char*& begin, const char* end) -> void
+      {
+        if(framer_type::skip(begin, end) != 0)
+        {
+          throw std::length_error("frame length greater than remaining stream length");
+        }
+      }
+    auto block_end(size_t block) const -> uint64_t
+      {
+        return block + 1 < block_offsets_.size()? block_offsets_[block + 1] : index_offset_;
+      }
+    auto read_index() -> void
+      {
+        auto trailer = file_ + size_ - detail::archive_format::trailer_size;
+        if(std::memcmp(file_, detail::archive_format::header_magic(), detail::archive_format::header_size) != 0
+        || std::memcmp(trailer + 16, detail::archive_format::trailer_magic(), 8) != 0)
+        {
+          throw std::runtime_error("not a templar archive");
+        }
+        auto p = trailer;
+        index_offset_  = Field<uint64_t>::deserialize(p, trailer + 16);
+        message_count_ = Field<uint64_t>::deserialize(p, trailer + 16);
+        if(index_offset_ < detail::archive_format::header_size || index_offset_ > static_cast<uint64_t>(trailer - file_))
+        {
+          throw std::runtime_error("corrupt archive index");
+        }
+        p = file_ + index_offset_;
+        block_offsets_   = Field<std::vector<uint64_t>>::deserialize(p, trailer);
+        block_sequences_ = Field<std::vector<uint64_t>>::deserialize(p, trailer);
+        auto ids         = Field<std::vector<uint8_t>>::deserialize(p, trailer);
+        for(auto id : ids)
+        {
+          type_blocks_[id] = Field<std::vector<uint32_t>>::deserialize(p, trailer);
+        }
+        validate_index();
+      }
+    auto validate_index() const -> void
+      {
+        auto valid = block_offsets_.size() == block_sequences_.size()
+                  && std::is_sorted(block_offsets_.begin(), block_offsets_.end())
+                  && std::is_sorted(block_sequences_.begin(), block_sequences_.end())
+                  && (block_offsets_.empty() || (block_offsets_.front() == detail::archive_format::header_size
+                                                 && block_offsets_.back() < index_offset_
+                                                 && block_sequences_.front() == 0
+                                                 && block_sequences_.back() < message_count_));
+        for(auto& blocks : type_blocks_)
+        {
+          for(auto block : blocks)
+          {
+            valid = valid && block < block_offsets_.size();
+          }
+        }
+        if(!valid)
+        {
+          throw std::runtime_error("corrupt archive index");
+        }
+      }
+
+    const char*                            file_          = nullptr;
+    size_t                                 size_          = 0;
+    uint64_t                               index_offset_  = 0;
+    uint64_t                               message_count_ = 0;
+    std::vector<uint64_t>                  block_offsets_;
+    std::vector<uint64_t>                  block_sequences_;
+    std::array<std::vector<uint32_t>, 256> type_blocks_;
+  };
+} /* namespace tpl */
+
+#endif//archive_hpp_20201024_143112_PDT
@@ -0,0 +1,197 @@
+#ifndef arena_hpp_20201031_111950_PDT
+#define arena_hpp_20201031_111950_PDT
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace tpl
+{
+  /*!
+   * \brief A monotonic arena: memory is carved sequentially out of large chunks, individual deallocation does nothing,
+   *        and `reset` releases everything at once--so that a batch of decoded messages, with all of their strings
+   *        and sequences, costs a handful of heap allocations in all, and is freed in one step.
+   *
+   *        Chunks are kept across `reset`, so that an arena which is reset between batches of similar size stops
+   *        touching the heap altogether.  Requests of more than half a chunk get a block of their own, which `reset`
+   *        does free.
+   */
+  class arena
+  {
+  public:
+    explicit arena(size_t chunk_size = 64 * 1024)
+      : chunk_size_(chunk_size)
+      {}
+    ~arena()
+      {
+        release(0);
+      }
+    arena(const arena&) = delete;
+    auto operator=(const arena&) -> arena& = delete;
+
+    auto allocate(size_t size, size_t alignment) -> void*
+      {
+        if(size > chunk_size_ / 2)
+        {
+          // Too large to share a chunk without wasting much of it.
+          oversized_.push_back(::operator new(size));
+          return oversized_.back();
+        }
+        for(;;)
+        {
+          if(current_ < chunks_.size())
+          {
+            auto base    = reinterpret_cast<uintptr_t>(chunks_[current_]);
+            auto aligned = (base + offset_ + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+            if(aligned + size <= base + chunk_size_)
+            {
+              offset_ = static_cast<size_t>(aligned + size - base);
+              used_  += size;
+              return reinterpret_cast<void*>(aligned);
+            }
+            ++current_;
+            offset_ = 0;
+          }
+          else
+          {
+            chunks_.push_back(::operator new(chunk_size_));
+          }
+        }
+      }
+    /*!
+     * \brief Releases everything allocated from the arena; the chunks are kept for reuse.
+     */
+    auto reset() -> void
+      {
+        for(auto& c : oversized_)
+        {
+          ::operator delete(c);
+        }
+        oversized_.clear();
+        current_ = 0;
+        offset_  = 0;
+        used_    = 0;
+      }
+    /*!
+     * \brief Releases everything, as `reset`, and returns all but `keep` chunks to the heap.
+     */
+    auto release(size_t keep) -> void
+      {
+        reset();
+        while(chunks_.size() > keep)
+        {
+          ::operator delete(chunks_.back());
+          chunks_.pop_back();
+        }
+      }
+    /*!
+     * \brief Bytes handed out since the last `reset`, excluding alignment padding.
+     */
+    auto bytes_used() const -> size_t { return used_; }
+    auto chunk_count() const -> size_t { return chunks_.size(); }
+
+    /*!
+     * \brief The arena which default-constructed `arena_allocator`s on this thread allocate from; see `scope`.
+     */
+    static auto current() -> arena* { return current_slot(); }
+
+    /*!
+     * \brief Makes `a` the current arena of this thread for the lifetime of the scope, e.g. while decoding a batch
+     *        into new messages, whose fields are created with default-constructed allocators.
+     */
+    class scope
+    {
+    public:
+      explicit scope(arena& a)
+        : previous_(current_slot())
+        {
+          current_slot() = &a;
+        }
+      ~scope()
+        {
+          current_slot() = previous_;
+        }
+      scope(const scope&) = delete;
+      auto operator=(const scope&) -> scope& = delete;
+    private:
+      arena* previous_;
+    };
+  private:
+    static auto current_slot() -> arena*&
+      {
+        static thread_local arena* current = nullptr;
+        return current;
+      }
+
+    size_t              chunk_size_;
+    std::vector<void*>  chunks_;
+    std::vector<void*>  oversized_;
+    size_t              current_ = 0;
+    size_t              offset_  = 0;
+    size_t              used_    = 0;
+  };
+
+  /*!
+   * \brief A standard allocator which draws from an `arena`: the one it is given, or else the thread's current arena
+   *        at the time it is default-constructed.  With no arena at all, it falls back on the global heap, so that
+   *        types which use it work anywhere.
+   *
+   *        Use it as the allocator of a `protocol::basic_message` to store the message's strings and sequences in an
+   *        arena.
+   */
+  template<typename T>
+  class arena_allocator
+  {
+  public:
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap            = std::true_type;
+
+    arena_allocator() noexcept
+      : arena_(arena::current())
+      {}
+    explicit arena_allocator(arena& a) noexcept
+      : arena_(&a)
+      {}
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) noexcept
+      : arena_(other.source())
+      {}
+
+    auto allocate(size_t n) -> T*
+      {
+        if(n > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+          throw std::bad_alloc();
+        }
+        if(arena_ == nullptr)
+        {
+          return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+      }
+    auto deallocate(T* p, size_t) noexcept -> void
+      {
+        if(arena_ == nullptr)
+        {
+          ::operator delete(p);
+        }
+      }
+    /*!
+     * \brief The arena allocated from, or `nullptr` for the global heap.
+     */
+    auto source() const noexcept -> arena* { return arena_; }
+
+    template<typename U>
+    friend auto operator==(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept -> bool { return lhs.source() == rhs.source(); }
+    template<typename U>
+    friend auto operator!=(const arena_allocator& lhs, const arena_allocator<U>& rhs) noexcept -> bool { return lhs.source() != rhs.source(); }
+  private:
+    arena* arena_;
+  };
+} /* namespace tpl */
+
+#endif//arena_hpp_20201031_111950_PDT
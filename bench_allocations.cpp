@@ -0,0 +1,67 @@
+/*
+ * The replaced global allocation functions; see `bench_allocations.hpp`.  Every form is replaced, so that each
+ * `delete` frees with the `free` matching its `new`'s `malloc`, however the compiler pairs them.
+ */
+#include "bench_allocations.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+  size_t count = 0;
+
+  auto allocate(std::size_t size) noexcept -> void*
+    {
+      ++count;
+      return std::malloc(size == 0? 1 : size);
+    }
+}
+
+auto bench::allocation_count() -> size_t
+{
+  return count;
+}
+
+auto operator new(std::size_t size) -> void*
+{
+  if(auto p = allocate(size))
+  {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+auto operator new[](std::size_t size) -> void*
+{
+  return operator new(size);
+}
+auto operator new(std::size_t size, const std::nothrow_t&) noexcept -> void*
+{
+  return allocate(size);
+}
+auto operator new[](std::size_t size, const std::nothrow_t&) noexcept -> void*
+{
+  return allocate(size);
+}
+auto operator delete(void* p) noexcept -> void
+{
+  std::free(p);
+}
+auto operator delete[](void* p) noexcept -> void
+{
+  std::free(p);
+}
+auto operator delete(void* p, std::size_t) noexcept -> void
+{
+  std::free(p);
+}
+auto operator delete[](void* p, std::size_t) noexcept -> void
+{
+  std::free(p);
+}
+auto operator delete(void* p, const std::nothrow_t&) noexcept -> void
+{
+  std::free(p);
+}
+auto operator delete[](void* p, const std::nothrow_t&) noexcept -> void
+{
+  std::free(p);
+}
@@ -0,0 +1,19 @@
+#ifndef bench_allocations_hpp_20201206_141027_PDT
+#define bench_allocations_hpp_20201206_141027_PDT
+
+/*
+ * Heap allocation counting for the benchmarks which report it, and the checks which rely on it: linking
+ * `bench_allocations.cpp` into a program replaces every form of the global `operator new` and `operator delete` with
+ * ones over `malloc` and `free`, which count each allocation.
+ */
+#include <cstddef>
+
+namespace bench
+{
+  /*!
+   * \brief The number of allocations made through the global `operator new` (in any of its forms) so far.
+   */
+  auto allocation_count() -> size_t;
+} /* namespace bench */
+
+#endif//bench_allocations_hpp_20201206_141027_PDT
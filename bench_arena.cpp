@@ -0,0 +1,148 @@
+/*
+ * Compares decoding batches of messages into the global heap with decoding them into an `arena`: each batch of
+ * decoded messages is kept until the batch is full, then discarded--one `free` per string and sequence for the heap,
+ * one `reset` for the arena.  Heap allocations are counted with a replaced global `operator new` (see
+ * `bench_allocations.hpp`).
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "protocol.hpp"
+#include "arena.hpp"
+#include "bench_allocations.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+
+  template<typename AllocatorT>
+    using order = protocol_class::basic_message<AllocatorT, 1, uint64_t, std::string, std::vector<int32_t>, std::vector<std::string>>;
+
+  using heap_order       = order<std::allocator<char>>;
+  using arena_order      = order<tpl::arena_allocator<char>>;
+  using heap_definition  = protocol_class::definition<heap_order>;
+  using arena_definition = protocol_class::definition<arena_order>;
+
+  constexpr size_t batch_size = 1024;
+
+  template<typename MessageT>
+  struct batcher
+  {
+    explicit batcher(std::vector<MessageT>& batch)
+      : batch(batch)
+      {}
+    auto operator()(MessageT&& m) -> void
+      {
+        sum += m.template get<0>() + m.template get<1>().size() + m.template get<2>().size() + m.template get<3>().size();
+        batch.push_back(std::move(m));
+      }
+    std::vector<MessageT>& batch;
+    uint64_t               sum = 0;
+  };
+
+  auto make_buffer(size_t message_count) -> std::string
+    {
+      heap_definition d;
+      std::string     buffer;
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        std::vector<std::string> tags { "venue-" + std::to_string(i % 7), "account-" + std::to_string(i % 1013) };
+        d.make_message<1>(uint64_t { i }, std::string(24 + i % 40, 's'), std::vector<int32_t>(i % 29, 3), tags).serialize(buffer);
+      }
+      return buffer;
+    }
+
+  /*
+   * Decodes `buffer` a batch at a time: `decode` decodes the messages at [begin, end), and `discard` is called after
+   * each batch.
+   */
+  template<typename DefinitionT, typename MessageT, typename DiscardT>
+  auto run(const std::string& buffer, std::vector<size_t>& boundaries, std::vector<MessageT>& batch, batcher<MessageT>& handler, DiscardT&& discard) -> void
+    {
+      for(size_t b = 0; b + 1 < boundaries.size(); ++b)
+      {
+        DefinitionT::dispatch(buffer.data() + boundaries[b], boundaries[b + 1] - boundaries[b], handler);
+        batch.clear();
+        discard();
+      }
+    }
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+  auto report(const char* name, double ns, size_t allocations, size_t bytes, size_t messages) -> void
+    {
+      std::printf("%-10s %12.2f %12.0f %14.3f\n", name, ns / messages, bytes / (ns / 1e9) / 1e6, static_cast<double>(allocations) / messages);
+    }
+} // namespace
+
+int main()
+{
+  constexpr size_t message_count = 1 << 20;
+  constexpr size_t repetitions   = 5;
+  auto buffer = make_buffer(message_count);
+
+  // Batch boundaries, found by skipping whole messages.
+  std::vector<size_t> boundaries { 0 };
+  auto p   = buffer.data();
+  auto end = buffer.data() + buffer.size();
+  for(size_t i = 1; p < end; ++i)
+  {
+    ++p;
+    tpl::detail::MessageSkipper<0, heap_order::field_tuple_type>::skip(p, end);
+    if(i % batch_size == 0 || p == end)
+    {
+      boundaries.push_back(static_cast<size_t>(p - buffer.data()));
+    }
+  }
+
+  std::vector<heap_order>  heap_batch;
+  std::vector<arena_order> arena_batch;
+  heap_batch.reserve(batch_size);
+  arena_batch.reserve(batch_size);
+  batcher<heap_order>  heap_handler(heap_batch);
+  batcher<arena_order> arena_handler(arena_batch);
+  tpl::arena           arena;
+
+  double heap_ns           = 0;
+  double arena_ns          = 0;
+  size_t heap_allocations  = 0;
+  size_t arena_allocations = 0;
+  for(size_t r = 0; r < repetitions; ++r)
+  {
+    auto before = bench::allocation_count();
+    heap_ns += time_ns([&] { run<heap_definition>(buffer, boundaries, heap_batch, heap_handler, [] {}); });
+    heap_allocations += bench::allocation_count() - before;
+
+    before = bench::allocation_count();
+    arena_ns += time_ns([&]
+      {
+        tpl::arena::scope scope(arena);
+        run<arena_definition>(buffer, boundaries, arena_batch, arena_handler, [&] { arena.reset(); });
+      });
+    arena_allocations += bench::allocation_count() - before;
+  }
+  if(heap_handler.sum != arena_handler.sum)
+  {
+    std::fprintf(stderr, "checksum mismatch\n");
+    return EXIT_FAILURE;
+  }
+  auto messages = message_count * repetitions;
+  auto bytes    = buffer.size() * repetitions;
+  std::printf("%zu messages in batches of %zu; arena of %zu chunks\n", message_count, batch_size, arena.chunk_count());
+  std::printf("%-10s %12s %12s %14s\n", "allocator", "ns/msg", "MB/s", "allocs/msg");
+  report("default", heap_ns, heap_allocations, bytes, messages);
+  report("arena", arena_ns, arena_allocations, bytes, messages);
+  return EXIT_SUCCESS;
+}
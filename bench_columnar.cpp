@@ -0,0 +1,95 @@
+/*
+ * Compares a stream of `DrawLine`-style messages in the row format (`definition::batch_encoder`, decoded with
+ * `definition::slot_decoder`) against the same messages as one `columnar_batch`, decoded both into columns (struct of
+ * arrays) and back into messages.  Each decode is followed by a pass summing one field, as a consumer would.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "columnar.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using line_type      = protocol_class::Message<1, short, int, long, uint8_t>;
+  using definition     = protocol_class::definition<line_type>;
+  using batch_type     = tpl::columnar_batch<line_type>;
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+} // namespace
+
+int main()
+{
+  constexpr size_t message_count = 1 << 20;
+  constexpr size_t repetitions   = 10;
+
+  std::vector<line_type> lines;
+  lines.reserve(message_count);
+  for(size_t i = 0; i < message_count; ++i)
+  {
+    lines.push_back(line_type { cpp::make_tuple(static_cast<short>(i % 1024), static_cast<int>(i * 3), static_cast<long>(i) << 8, static_cast<uint8_t>(i % 7)) });
+  }
+
+  definition::batch_encoder rows;
+  definition::slot_decoder  slots;
+  cpp::string               batch;
+  batch_type::columns_type  columns;
+  std::vector<line_type>    decoded;
+  double row_encode_ns     = 0;
+  double row_decode_ns     = 0;
+  double column_encode_ns  = 0;
+  double column_decode_ns  = 0;
+  double column_to_rows_ns = 0;
+  long   row_sum           = 0;
+  long   column_sum        = 0;
+  long   column_row_sum    = 0;
+  for(size_t r = 0; r < repetitions; ++r)
+  {
+    rows.clear();
+    batch.clear();
+    row_encode_ns    += time_ns([&] { rows.encode_range(lines.begin(), lines.end()); });
+    column_encode_ns += time_ns([&] { batch_type::serialize(lines, batch); });
+    row_decode_ns    += time_ns([&]
+      {
+        slots.dispatch(rows.data(), rows.size(), [&](const line_type& m) { row_sum += m.get<2>(); });
+      });
+    column_decode_ns += time_ns([&]
+      {
+        batch_type::deserialize(batch, columns);
+        for(auto value : cpp::get<2>(columns))
+        {
+          column_sum += value;
+        }
+      });
+    column_to_rows_ns += time_ns([&]
+      {
+        batch_type::deserialize(batch, decoded);
+        for(const auto& m : decoded)
+        {
+          column_row_sum += m.get<2>();
+        }
+      });
+  }
+  if(row_sum != column_sum || row_sum != column_row_sum)
+  {
+    std::fprintf(stderr, "columnar decode disagrees with row decode\n");
+    return 1;
+  }
+  auto total = static_cast<double>(message_count * repetitions);
+  std::printf("%-24s %12s %12s %12s\n", "format", "encode ns", "decode ns", "bytes/msg");
+  std::printf("%-24s %12.2f %12.2f %12.2f\n", "rows", row_encode_ns / total, row_decode_ns / total, static_cast<double>(rows.size()) / message_count);
+  std::printf("%-24s %12.2f %12.2f %12.2f\n", "columnar -> columns", column_encode_ns / total, column_decode_ns / total, static_cast<double>(batch.size()) / message_count);
+  std::printf("%-24s %12s %12.2f %12s\n", "columnar -> messages", "", column_to_rows_ns / total, "");
+  return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Compares a telemetry-like stream--each message a reading from one of a few sensors, whose timestamp creeps upward,
+ * whose value drifts, and whose other fields rarely change--encoded in the row format (`definition::batch_encoder`,
+ * decoded with `definition::slot_decoder`) and with a `delta_encoder` (decoded with a `delta_decoder`).
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "delta.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  // timestamp (ns), sensor, host, reading, status, alarm
+  using reading_type   = protocol_class::Message<1, int64_t, uint32_t, cpp::string, int32_t, uint8_t, bool>;
+  // timestamp (ns), host, uptime (s), load (per mille)
+  using heartbeat_type = protocol_class::Message<2, int64_t, cpp::string, uint32_t, uint16_t>;
+  using definition     = protocol_class::definition<reading_type, heartbeat_type>;
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+  struct summer
+  {
+    auto operator()(const reading_type& m) -> void { sum += m.get<3>(); }
+    auto operator()(const heartbeat_type& m) -> void { sum += m.get<3>(); }
+    long sum = 0;
+  };
+} // namespace
+
+int main()
+{
+  constexpr size_t message_count = 1 << 20;
+  constexpr size_t repetitions   = 10;
+
+  const char* hosts[] = { "edge-01.rack-a.example.net", "edge-02.rack-a.example.net", "edge-03.rack-b.example.net" };
+  std::vector<reading_type>   readings;
+  std::vector<heartbeat_type> heartbeats;
+  std::vector<bool>           is_reading;
+  int64_t  now   = 1600000000000000000;
+  uint32_t state = 12345;
+  for(size_t i = 0; i < message_count; ++i)
+  {
+    state = state * 1103515245 + 12345;
+    now  += 1000 + (state >> 16) % 500;
+    if(i % 16 == 15)
+    {
+      heartbeats.push_back(heartbeat_type { cpp::make_tuple(now, cpp::string(hosts[i % 3]), static_cast<uint32_t>(i / 1000), static_cast<uint16_t>(200 + (state >> 20) % 50)) });
+      is_reading.push_back(false);
+    }
+    else
+    {
+      auto sensor = static_cast<uint32_t>(i % 8);
+      readings.push_back(reading_type { cpp::make_tuple(now, sensor, cpp::string(hosts[sensor % 3]), static_cast<int32_t>(20000 + sensor * 100 + (state >> 24) % 16), static_cast<uint8_t>(i % 4096 == 0), (state >> 8) % 1000 == 0) });
+      is_reading.push_back(true);
+    }
+  }
+
+  definition::batch_encoder rows;
+  definition::slot_decoder  slots;
+  cpp::string               deltas;
+  double row_encode_ns   = 0;
+  double row_decode_ns   = 0;
+  double delta_encode_ns = 0;
+  double delta_decode_ns = 0;
+  summer row_sum;
+  summer delta_sum;
+  for(size_t r = 0; r < repetitions; ++r)
+  {
+    rows.clear();
+    deltas.clear();
+    row_encode_ns += time_ns([&]
+      {
+        size_t reading = 0;
+        size_t heartbeat = 0;
+        for(auto is : is_reading)
+        {
+          if(is) rows.encode(readings[reading++]); else rows.encode(heartbeats[heartbeat++]);
+        }
+      });
+    delta_encode_ns += time_ns([&]
+      {
+        tpl::delta_encoder<definition> encoder;
+        size_t reading = 0;
+        size_t heartbeat = 0;
+        for(auto is : is_reading)
+        {
+          if(is) encoder.encode(readings[reading++], deltas); else encoder.encode(heartbeats[heartbeat++], deltas);
+        }
+      });
+    row_decode_ns += time_ns([&] { slots.dispatch(rows.data(), rows.size(), row_sum); });
+    delta_decode_ns += time_ns([&]
+      {
+        tpl::delta_decoder<definition> decoder;
+        decoder.decode(deltas, delta_sum);
+      });
+  }
+  if(row_sum.sum != delta_sum.sum)
+  {
+    std::fprintf(stderr, "delta decode disagrees with row decode\n");
+    return 1;
+  }
+  auto total = static_cast<double>(message_count * repetitions);
+  std::printf("%-10s %12s %12s %12s\n", "encoding", "encode ns", "decode ns", "bytes/msg");
+  std::printf("%-10s %12.2f %12.2f %12.2f\n", "rows", row_encode_ns / total, row_decode_ns / total, static_cast<double>(rows.size()) / message_count);
+  std::printf("%-10s %12.2f %12.2f %12.2f\n", "delta", delta_encode_ns / total, delta_decode_ns / total, static_cast<double>(deltas.size()) / message_count);
+  std::printf("reduction  %.2fx\n", static_cast<double>(rows.size()) / static_cast<double>(deltas.size()));
+  return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * Compares encoding and decoding a message of fixed-width fields as one block--one bounds check, then each field at
+ * its constant offset--against the fieldwise path, which checks and advances a cursor once per field; over a batch
+ * which fits in cache, and over one which does not, where both paths wait on memory.
+ *
+ * Only decoding can gain: the fieldwise encoder never checked bounds, so both paths store each field once, and the
+ * body can't be copied as one block because a tuple's layout differs from the wire's.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "protocol.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using message_type   = protocol_class::Message<1, short, int, long, uint8_t, double, uint32_t>;
+  using tuple_type     = message_type::field_tuple_type;
+
+  /*
+   * Reference implementation of the fieldwise path: every field checks the remaining length and advances the cursor.
+   */
+  auto fieldwise_serialize(char*& out, const tuple_type& t) -> void
+    {
+      tpl::Field<short>::serialize(out, cpp::get<0>(t));
+      tpl::Field<int>::serialize(out, cpp::get<1>(t));
+      tpl::Field<long>::serialize(out, cpp::get<2>(t));
+      tpl::Field<uint8_t>::serialize(out, cpp::get<3>(t));
+      tpl::Field<double>::serialize(out, cpp::get<4>(t));
+      tpl::Field<uint32_t>::serialize(out, cpp::get<5>(t));
+    }
+
+  auto fieldwise_deserialize(const char*& begin, const char* end) -> tuple_type
+    {
+      auto f0 = tpl::Field<short>::deserialize(begin, end);
+      auto f1 = tpl::Field<int>::deserialize(begin, end);
+      auto f2 = tpl::Field<long>::deserialize(begin, end);
+      auto f3 = tpl::Field<uint8_t>::deserialize(begin, end);
+      auto f4 = tpl::Field<double>::deserialize(begin, end);
+      auto f5 = tpl::Field<uint32_t>::deserialize(begin, end);
+      return tuple_type { f0, f1, f2, f3, f4, f5 };
+    }
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+  struct timings
+  {
+    double block_encode_ns = 0;
+    double field_encode_ns = 0;
+    double block_decode_ns = 0;
+    double field_decode_ns = 0;
+  };
+
+  /*
+   * Encodes and decodes `message_count` messages `repetitions` times each way; false if the paths disagree.
+   */
+  auto run(size_t message_count, size_t repetitions, timings& result) -> bool
+    {
+      constexpr size_t body_size = tpl::detail::MessageSerializer<0, tuple_type>::fixed_size;
+
+      std::vector<tuple_type> messages;
+      messages.reserve(message_count);
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        messages.emplace_back(static_cast<short>(i), static_cast<int>(i * 3), static_cast<long>(i) << 20, static_cast<uint8_t>(i), i * 0.5, static_cast<uint32_t>(~i));
+      }
+      std::string block_buffer(message_count * body_size, '\0');
+      std::string field_buffer(message_count * body_size, '\0');
+
+      long block_sum = 0;
+      long field_sum = 0;
+      for(size_t r = 0; r < repetitions; ++r)
+      {
+        result.block_encode_ns += time_ns([&] {
+          auto out = &block_buffer[0];
+          for(auto& m : messages)
+          {
+            tpl::detail::MessageSerializer<0, tuple_type>::serialize(out, m);
+          }
+        });
+        result.field_encode_ns += time_ns([&] {
+          auto out = &field_buffer[0];
+          for(auto& m : messages)
+          {
+            fieldwise_serialize(out, m);
+          }
+        });
+        result.block_decode_ns += time_ns([&] {
+          auto begin = block_buffer.data();
+          auto end   = begin + block_buffer.size();
+          while(begin < end)
+          {
+            auto t = tpl::detail::MessageDeserializer<0, tuple_type>::deserialize(begin, end);
+            block_sum += cpp::get<2>(t) + cpp::get<5>(t);
+          }
+        });
+        result.field_decode_ns += time_ns([&] {
+          auto begin = field_buffer.data();
+          auto end   = begin + field_buffer.size();
+          while(begin < end)
+          {
+            auto t = fieldwise_deserialize(begin, end);
+            field_sum += cpp::get<2>(t) + cpp::get<5>(t);
+          }
+        });
+      }
+      auto total = static_cast<double>(message_count * repetitions);
+      result.block_encode_ns /= total;
+      result.field_encode_ns /= total;
+      result.block_decode_ns /= total;
+      result.field_decode_ns /= total;
+      return block_buffer == field_buffer && block_sum == field_sum;
+    }
+} // namespace
+
+int main()
+{
+  // About 100 KiB of messages and their encoding, and about 64 MiB.
+  timings in_cache;
+  timings in_memory;
+  if(!run(1 << 12, 2560, in_cache) || !run(1 << 20, 10, in_memory))
+  {
+    std::fprintf(stderr, "encoding mismatch between block and fieldwise paths\n");
+    return 1;
+  }
+  std::printf("%-20s %14s %14s %10s\n", "", "block ns/msg", "field ns/msg", "speedup");
+  std::printf("%-20s %14.2f %14.2f %9.2fx\n", "encode (in cache)", in_cache.block_encode_ns, in_cache.field_encode_ns, in_cache.field_encode_ns / in_cache.block_encode_ns);
+  std::printf("%-20s %14.2f %14.2f %9.2fx\n", "decode (in cache)", in_cache.block_decode_ns, in_cache.field_decode_ns, in_cache.field_decode_ns / in_cache.block_decode_ns);
+  std::printf("%-20s %14.2f %14.2f %9.2fx\n", "encode (in memory)", in_memory.block_encode_ns, in_memory.field_encode_ns, in_memory.field_encode_ns / in_memory.block_encode_ns);
+  std::printf("%-20s %14.2f %14.2f %9.2fx\n", "decode (in memory)", in_memory.block_decode_ns, in_memory.field_decode_ns, in_memory.field_decode_ns / in_memory.block_decode_ns);
+  std::printf("\nEncoding is at parity by construction: both paths store each field once, unchecked.  A multiple is only\n"
+              "possible for decoding, and only while the batch is in cache; out of it, both paths are bound by memory.\n");
+  return 0;
+}
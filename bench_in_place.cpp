@@ -0,0 +1,113 @@
+/*
+ * Compares decoding into fresh messages (`definition::dispatch`) with decoding into reused per-type messages
+ * (`definition::slot_decoder` and `visitor`), counting heap allocations with a replaced global `operator new` (see
+ * `bench_allocations.hpp`).  That the reusing decoders allocate nothing once warmed up is checked by
+ * `check_in_place.cpp`.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "protocol.hpp"
+#include "bench_allocations.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using order          = protocol_class::Message<1, uint64_t, std::string, int64_t, std::vector<int32_t>>;
+  using text           = protocol_class::Message<2, tpl::compact_string, std::vector<std::string>>;
+  using heartbeat      = protocol_class::Message<3, uint64_t>;
+  using definition     = protocol_class::definition<order, text, heartbeat>;
+
+  struct checksum
+  {
+    auto operator()(const order& m) -> void     { sum += m.get<0>() + m.get<1>().size() + m.get<3>().size(); }
+    auto operator()(const text& m) -> void      { sum += m.get<0>().size() + m.get<1>().size(); }
+    auto operator()(const heartbeat& m) -> void { sum += m.get<0>(); }
+    uint64_t sum = 0;
+  };
+
+  class checksum_visitor : public definition::visitor
+  {
+  public:
+    auto visit(const order& m) -> void override     { handler(m); }
+    auto visit(const text& m) -> void override      { handler(m); }
+    auto visit(const heartbeat& m) -> void override { handler(m); }
+    checksum handler;
+  };
+
+  auto make_buffer(size_t message_count) -> std::string
+    {
+      definition  d;
+      std::string buffer;
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        switch(i % 4)
+        {
+          case 0:
+          case 1:
+            d.make_message<1>(uint64_t { i }, std::string("instrument-name-" + std::to_string(i % 97)), int64_t { -1 }, std::vector<int32_t>(i % 13, 7)).serialize(buffer);
+            break;
+          case 2:
+            d.make_message<2>(tpl::compact_string(std::string(i % 61, 't')), std::vector<std::string> { "first tag of some length", "second" }).serialize(buffer);
+            break;
+          default:
+            d.make_message<3>(uint64_t { i }).serialize(buffer);
+        }
+      }
+      return buffer;
+    }
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+  /*
+   * Runs `f` once to warm up, then `repetitions` times, reporting the time and allocations per message of the latter.
+   */
+  template<typename FunctionT>
+  auto measure(const char* name, size_t message_count, size_t repetitions, FunctionT&& f) -> void
+    {
+      f();
+      auto   allocations = bench::allocation_count();
+      double ns          = 0;
+      for(size_t r = 0; r < repetitions; ++r)
+      {
+        ns += time_ns(f);
+      }
+      allocations = bench::allocation_count() - allocations;
+      auto total  = static_cast<double>(message_count * repetitions);
+      std::printf("%-24s %12.2f %14.3f\n", name, ns / total, static_cast<double>(allocations) / total);
+    }
+} // namespace
+
+int main()
+{
+  constexpr size_t message_count = 1 << 20;
+  constexpr size_t repetitions   = 10;
+  auto buffer = make_buffer(message_count);
+
+  checksum                 fresh;
+  checksum                 reused;
+  checksum_visitor         visitor;
+  definition::slot_decoder decoder;
+  std::printf("%-24s %12s %14s\n", "decoder", "ns/msg", "allocs/msg");
+  measure("dispatch (fresh)", message_count, repetitions, [&] { definition::dispatch(buffer, fresh); });
+  measure("slot_decoder", message_count, repetitions, [&] { decoder.dispatch(buffer, reused); });
+  measure("visitor", message_count, repetitions, [&] { visitor.accept(buffer); });
+  if(fresh.sum != reused.sum || fresh.sum != visitor.handler.sum)
+  {
+    std::fprintf(stderr, "checksum mismatch\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
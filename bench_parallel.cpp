@@ -0,0 +1,131 @@
+/*
+ * Measures the decode throughput of `parallel_decoder` on a framed buffer of mixed messages, for 1 to 16 threads,
+ * against a single-threaded `framed_definition::dispatch` of the same buffer.  Per-thread handlers are timed both with
+ * the chunk-boundary scan and with precomputed boundaries (as from a side index), and the ordered merge with the scan.
+ *
+ * Each figure is the fastest of several runs.  Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for
+ * meaningful numbers.  Scaling is bounded by the number of cores available, which is printed first; rows with more
+ * threads than that are marked, since their threads only take turns on the cores.
+ */
+#include "parallel.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using quote          = protocol_class::Message<1, uint32_t, int64_t, int64_t, uint32_t>;
+  using trade          = protocol_class::Message<2, uint32_t, int64_t, tpl::varint<uint64_t>, tpl::string_ref>;
+  using note           = protocol_class::Message<3, tpl::zigzag<int32_t>, std::string>;
+  using definition     = protocol_class::framed_definition<quote, trade, note>;
+
+  struct checksum
+  {
+    auto operator()(const quote& m) -> void { sum += m.get<0>() + static_cast<uint64_t>(m.get<1>() - m.get<2>()); }
+    auto operator()(const trade& m) -> void { sum += m.get<0>() + m.get<2>() + m.get<3>().size(); }
+    auto operator()(const note& m)  -> void { sum += static_cast<uint64_t>(m.get<0>().value()) + m.get<1>().size(); }
+    uint64_t sum = 0;
+  };
+
+  auto make_buffer(size_t message_count) -> std::string
+    {
+      definition  d;
+      std::string buffer;
+      std::string text(48, 'n');
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        auto k = static_cast<uint32_t>(i * 2654435761u);
+        switch(i % 8)
+        {
+          case 7:
+            definition::serialize(d.make_message<3>(static_cast<int32_t>(k % 1000) - 500, text.substr(0, k % 48)), buffer);
+            break;
+          case 3:
+          case 5:
+            definition::serialize(d.make_message<2>(k, int64_t { 100 } * k, uint64_t { k % 10000 }, tpl::string_ref(text.data(), 8)), buffer);
+            break;
+          default:
+            definition::serialize(d.make_message<1>(k, int64_t { k } + 5, int64_t { k } - 5, k >> 3), buffer);
+        }
+      }
+      return buffer;
+    }
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+  auto fastest(double& best, double ns) -> void
+    {
+      if(best == 0 || ns < best)
+      {
+        best = ns;
+      }
+    }
+} // namespace
+
+int main()
+{
+  constexpr size_t message_count = 1 << 22;
+  constexpr size_t repetitions   = 5;
+  auto buffer = make_buffer(message_count);
+  auto mb     = static_cast<double>(buffer.size()) / 1e6;
+  auto cores  = std::max(std::thread::hardware_concurrency(), 1u);
+
+  checksum reference;
+  double   serial_ns = 0;
+  for(size_t r = 0; r < repetitions; ++r)
+  {
+    checksum run;
+    fastest(serial_ns, time_ns([&] { definition::dispatch(buffer, run); }));
+    reference = run;
+  }
+  std::printf("%zu messages, %.1f MB, %u hardware threads\n", message_count, buffer.size() / 1e6, cores);
+  std::printf("%-8s %16s %9s %16s %9s %16s %9s\n", "threads", "scanned MB/s", "speedup", "indexed MB/s", "speedup", "ordered MB/s", "speedup");
+  std::printf("%-8s %16.0f %9s\n", "serial", mb / (serial_ns / 1e9), "1.00x");
+
+  for(size_t threads : { 1, 2, 4, 8, 16 })
+  {
+    tpl::parallel_decoder<definition> decoder(threads);
+    auto   boundaries = decoder.boundaries(buffer.data(), buffer.size());
+    double scanned_ns = 0;
+    double indexed_ns = 0;
+    double ordered_ns = 0;
+    for(size_t r = 0; r < repetitions; ++r)
+    {
+      std::vector<checksum> handlers(threads);
+      std::vector<checksum> indexed_handlers(threads);
+      checksum              ordered;
+      fastest(scanned_ns, time_ns([&] { decoder.decode(buffer, handlers); }));
+      fastest(indexed_ns, time_ns([&] { decoder.decode(buffer.data(), buffer.size(), boundaries, indexed_handlers); }));
+      fastest(ordered_ns, time_ns([&] { decoder.decode_ordered(buffer, ordered); }));
+      uint64_t sum         = 0;
+      uint64_t indexed_sum = 0;
+      for(size_t t = 0; t < threads; ++t)
+      {
+        sum         += handlers[t].sum;
+        indexed_sum += indexed_handlers[t].sum;
+      }
+      if(sum != reference.sum || indexed_sum != reference.sum || ordered.sum != reference.sum)
+      {
+        std::fprintf(stderr, "checksum mismatch with %zu threads\n", threads);
+        return 1;
+      }
+    }
+    std::printf("%-8zu %16.0f %8.2fx %16.0f %8.2fx %16.0f %8.2fx%s\n", threads,
+                mb / (scanned_ns / 1e9), serial_ns / scanned_ns,
+                mb / (indexed_ns / 1e9), serial_ns / indexed_ns,
+                mb / (ordered_ns / 1e9), serial_ns / ordered_ns,
+                threads > cores? "  (oversubscribed)" : "");
+  }
+  return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Streams messages through a pipe from a writer thread, and measures the sustained rate at which they are handled and
+ * the latency from encoding to handling, for:
+ *
+ *   - the usual glue: one thread which reads the pipe and feeds a `stream_decoder`;
+ *   - a `pipeline`, handling on the decoding thread;
+ *   - a `pipeline` routing each message type to a worker thread of its own.
+ *
+ * The writer runs flat out, so the latencies include the time messages spend queued behind one another, in the pipe
+ * and in the pipeline's buffers and rings.  How much the stages overlap depends on how many cores are free for them.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "pipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using quote_type     = protocol_class::Message<1, int64_t, uint32_t, double, int>;
+  using news_type      = protocol_class::Message<2, int64_t, cpp::string>;
+  using definition     = protocol_class::framed_definition<quote_type, news_type>;
+
+  auto now_ns() -> int64_t
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+  /*
+   * Records the latency of each message from its timestamp, the first field of every message type.
+   */
+  struct recorder
+  {
+    template<typename MessageT>
+    auto operator()(const MessageT& m) -> void
+      {
+        latencies.push_back(now_ns() - m.template get<0>());
+      }
+    std::vector<int64_t> latencies;
+  };
+
+  class recording_visitor : public definition::visitor
+  {
+  public:
+    explicit recording_visitor(recorder& r)
+      : recorder_(r)
+      {}
+    virtual auto visit(const quote_type& m) -> void override { recorder_(m); }
+    virtual auto visit(const news_type& m) -> void override { recorder_(m); }
+  private:
+    recorder& recorder_;
+  };
+
+  /*
+   * Writes `message_count` messages, in bursts of 64, each timestamped as it is encoded; one in eight is news.
+   */
+  auto write_messages(int fd, size_t message_count) -> void
+    {
+      tpl::fd_writer            writer(fd);
+      definition::batch_encoder encoder;
+      cpp::string               headline(48, 'x');
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        if(i % 8 == 7)
+        {
+          encoder.encode(news_type { cpp::make_tuple(now_ns(), headline) });
+        }
+        else
+        {
+          encoder.encode(quote_type { cpp::make_tuple(now_ns(), static_cast<uint32_t>(i % 500), 100.0 + static_cast<double>(i % 100), static_cast<int>(i)) });
+        }
+        if(i % 64 == 63)
+        {
+          encoder.flush(writer);
+        }
+      }
+      encoder.flush(writer);
+      ::close(fd);
+    }
+
+  auto percentile(std::vector<int64_t>& samples, double p) -> double
+    {
+      if(samples.empty())
+      {
+        return 0;
+      }
+      auto n = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+      std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(n), samples.end());
+      return static_cast<double>(samples[n]) / 1000.0;
+    }
+
+  /*
+   * Runs `consume(read_fd, recorders)` against a writer thread, and reports the rate and latency percentiles.
+   */
+  template<typename ConsumeT>
+  auto run(const char* name, size_t message_count, size_t recorder_count, ConsumeT&& consume) -> bool
+    {
+      int fds[2];
+      if(::pipe(fds) != 0)
+      {
+        std::perror("pipe");
+        return false;
+      }
+      std::vector<recorder> recorders(recorder_count);
+      for(auto& r : recorders)
+      {
+        r.latencies.reserve(message_count);
+      }
+      auto        start = std::chrono::steady_clock::now();
+      std::thread writer([&] { write_messages(fds[1], message_count); });
+      consume(fds[0], recorders);
+      auto        stop  = std::chrono::steady_clock::now();
+      writer.join();
+      ::close(fds[0]);
+
+      std::vector<int64_t> latencies;
+      for(auto& r : recorders)
+      {
+        latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+      }
+      if(latencies.size() != message_count)
+      {
+        std::fprintf(stderr, "%s: handled %zu of %zu messages\n", name, latencies.size(), message_count);
+        return false;
+      }
+      auto seconds = std::chrono::duration<double>(stop - start).count();
+      auto p50     = percentile(latencies, 0.50);
+      auto p99     = percentile(latencies, 0.99);
+      std::printf("%-22s %12.2f %12.1f %12.1f\n", name, static_cast<double>(message_count) / seconds / 1e6, p50, p99);
+      return true;
+    }
+} // namespace
+
+int main()
+{
+  constexpr size_t message_count = 2000000;
+  std::printf("%-22s %12s %12s %12s\n", "consumer", "Mmsg/s", "p50 us", "p99 us");
+  auto ok = run("read + stream_decoder", message_count, 1, [](int fd, std::vector<recorder>& recorders)
+    {
+      recording_visitor          visitor(recorders[0]);
+      definition::stream_decoder decoder(visitor);
+      tpl::fd_reader             reader(fd);
+      std::vector<char>          buffer(64 * 1024);
+      while(auto n = reader(buffer.data(), buffer.size()))
+      {
+        decoder.feed(buffer.data(), n);
+      }
+    });
+  ok = run("pipeline", message_count, 1, [](int fd, std::vector<recorder>& recorders)
+    {
+      tpl::pipeline<definition> p(fd);
+      p.run(recorders[0]);
+    }) && ok;
+  ok = run("pipeline, 2 workers", message_count, 2, [](int fd, std::vector<recorder>& recorders)
+    {
+      tpl::pipeline<definition> p(fd);
+      p.run(recorders, [](uint8_t id) { return id == 1? 0 : 1; });
+    }) && ok;
+  return ok? 0 : 1;
+}
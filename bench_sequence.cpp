@@ -0,0 +1,77 @@
+/*
+ * Measures decoding throughput of a 1M-element `std::vector<int32_t>` field, against a plain `memcpy` of the same
+ * bytes into preallocated memory.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "field.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+  auto report(const char* name, double ns, size_t bytes, size_t repetitions) -> void
+    {
+      auto gb_per_s = static_cast<double>(bytes * repetitions) / ns;
+      std::printf("%-24s %12.1f us %10.2f GB/s\n", name, ns / repetitions / 1000.0, gb_per_s);
+    }
+} // namespace
+
+int main()
+{
+  using sequence_type = std::vector<int32_t>;
+  using field_type    = tpl::Field<sequence_type>;
+  constexpr size_t element_count = 1 << 20;
+  constexpr size_t repetitions   = 50;
+
+  sequence_type source(element_count);
+  for(size_t i = 0; i < element_count; ++i)
+  {
+    source[i] = static_cast<int32_t>(i * 2654435761u);
+  }
+  std::string encoded;
+  field_type::serialize(encoded, source);
+  auto payload_bytes = sizeof(int32_t) * element_count;
+
+  double  decode_ns = 0;
+  int64_t checksum  = 0;
+  for(size_t r = 0; r < repetitions; ++r)
+  {
+    decode_ns += time_ns([&]
+      {
+        const char* begin = encoded.data();
+        auto decoded = field_type::deserialize(begin, encoded.data() + encoded.size());
+        checksum += decoded[r];
+      });
+  }
+
+  std::vector<char> target(payload_bytes);
+  double memcpy_ns = 0;
+  for(size_t r = 0; r < repetitions; ++r)
+  {
+    memcpy_ns += time_ns([&]
+      {
+        std::memcpy(target.data(), encoded.data() + encoded.size() - payload_bytes, payload_bytes);
+        checksum += target[r];
+      });
+  }
+
+  std::printf("%-24s %15s %15s\n", "1M x int32_t", "per decode", "throughput");
+  report("Field<vector> decode", decode_ns, payload_bytes, repetitions);
+  report("memcpy (preallocated)", memcpy_ns, payload_bytes, repetitions);
+  std::printf("(checksum %lld)\n", static_cast<long long>(checksum));
+  return 0;
+}
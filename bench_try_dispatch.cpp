@@ -0,0 +1,123 @@
+/*
+ * Compares the non-throwing `definition::try_dispatch`, which checks each message before decoding it, against
+ * `definition::dispatch` on valid input, for a protocol of fixed-width messages and for one with string and sequence
+ * fields, both unframed and framed.  The fastest of the repetitions of each is reported.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "protocol.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using point_type     = protocol_class::Message<1, int, int>;
+  using line_type      = protocol_class::Message<2, short, int, long, uint8_t>;
+  using label_type     = protocol_class::Message<3, int, cpp::string>;
+  using path_type      = protocol_class::Message<4, std::vector<int>, tpl::varint<uint32_t>>;
+
+  struct sink
+  {
+    template<typename MessageT>
+    auto operator()(const MessageT& m) -> void
+      {
+        count += tpl::detail::MessageSerializer<0, typename MessageT::field_tuple_type>::serialized_size(m.fields());
+      }
+    size_t count = 0;
+  };
+
+  template<typename DefinitionT>
+  auto make_fixed_buffer(size_t message_count) -> std::string
+    {
+      std::string buffer;
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        if(i & 1)
+        {
+          DefinitionT::serialize(point_type { cpp::make_tuple(static_cast<int>(i), -static_cast<int>(i)) }, buffer);
+        }
+        else
+        {
+          DefinitionT::serialize(line_type { cpp::make_tuple(static_cast<short>(i), static_cast<int>(i), static_cast<long>(i), static_cast<uint8_t>(i)) }, buffer);
+        }
+      }
+      return buffer;
+    }
+
+  template<typename DefinitionT>
+  auto make_mixed_buffer(size_t message_count) -> std::string
+    {
+      std::string buffer;
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        switch(i % 4)
+        {
+          case 0: DefinitionT::serialize(point_type { cpp::make_tuple(static_cast<int>(i), 1) }, buffer); break;
+          case 1: DefinitionT::serialize(line_type { cpp::make_tuple(static_cast<short>(i), 2, 3L, static_cast<uint8_t>(4)) }, buffer); break;
+          case 2: DefinitionT::serialize(label_type { cpp::make_tuple(static_cast<int>(i), cpp::string(i % 24, 'x')) }, buffer); break;
+          default: DefinitionT::serialize(path_type { cpp::make_tuple(std::vector<int>(i % 8, 5), tpl::varint<uint32_t>(static_cast<uint32_t>(i))) }, buffer); break;
+        }
+      }
+      return buffer;
+    }
+
+  template<typename FunctionT>
+  auto time_ns(FunctionT&& f) -> double
+    {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      auto stop  = std::chrono::steady_clock::now();
+      return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+  auto fastest(double& best, double ns) -> void
+    {
+      if(best == 0 || ns < best)
+      {
+        best = ns;
+      }
+    }
+
+  template<typename DefinitionT>
+  auto run(const char* name, const std::string& buffer, size_t message_count, size_t repetitions) -> bool
+    {
+      typename DefinitionT::slot_decoder throwing_decoder;
+      typename DefinitionT::slot_decoder checked_decoder;
+      sink   throwing_sink;
+      sink   checked_sink;
+      double throwing_ns = 0;
+      double checked_ns  = 0;
+      bool   ok          = true;
+      for(size_t r = 0; r < repetitions; ++r)
+      {
+        fastest(throwing_ns, time_ns([&] { throwing_decoder.dispatch(buffer.data(), buffer.size(), throwing_sink); }));
+        fastest(checked_ns, time_ns([&] { ok = ok && checked_decoder.try_dispatch(buffer.data(), buffer.size(), checked_sink); }));
+      }
+      if(!ok || throwing_sink.count != checked_sink.count)
+      {
+        std::fprintf(stderr, "%s: try_dispatch disagrees with dispatch\n", name);
+        return false;
+      }
+      auto total = static_cast<double>(message_count);
+      std::printf("%-18s %16.2f %16.2f %9.2fx\n", name, throwing_ns / total, checked_ns / total, checked_ns / throwing_ns);
+      return true;
+    }
+} // namespace
+
+int main()
+{
+  using unframed = protocol_class::definition<point_type, line_type, label_type, path_type>;
+  using framed   = protocol_class::framed_definition<point_type, line_type, label_type, path_type>;
+
+  constexpr size_t message_count = 1 << 20;
+  constexpr size_t repetitions   = 10;
+  std::printf("%-18s %16s %16s %10s\n", "input", "dispatch ns/msg", "checked ns/msg", "ratio");
+  auto ok = run<unframed>("fixed, unframed", make_fixed_buffer<unframed>(message_count), message_count, repetitions);
+  ok = run<framed>("fixed, framed", make_fixed_buffer<framed>(message_count), message_count, repetitions) && ok;
+  ok = run<unframed>("mixed, unframed", make_mixed_buffer<unframed>(message_count), message_count, repetitions) && ok;
+  ok = run<framed>("mixed, framed", make_mixed_buffer<framed>(message_count), message_count, repetitions) && ok;
+  return ok? 0 : 1;
+}
@@ -0,0 +1,55 @@
+#ifndef buffer_hpp_20201004_093417_PDT
+#define buffer_hpp_20201004_093417_PDT
+
+#include <cstddef>
+#include <cpp/cpp.hpp>
+
+namespace tpl {
+/*!
+ * \brief A byte sink over caller-owned memory of fixed capacity, such as a preallocated I/O buffer.
+ *
+ *        Byte sinks provide `prepare(n)`, which claims the next `n` bytes of the sink and returns a pointer to them,
+ *        or returns `nullptr`--claiming nothing--if they do not fit.  `Message::serialize(sink)` relies on this to
+ *        either write a whole message or nothing at all.
+ */
+class fixed_buffer
+{
+public:
+  fixed_buffer(char* data, size_t capacity)
+    : data_(data)
+    , capacity_(capacity)
+    , size_(0)
+    {}
+  template<size_t N>
+  explicit fixed_buffer(char (&data)[N])
+    : fixed_buffer(data, N)
+    {}
+
+  auto prepare(size_t n) -> char*
+    {
+      if(capacity_ - size_ < n)
+      {
+        return nullptr;
+      }
+      auto out = data_ + size_;
+      size_ += n;
+      return out;
+    }
+  /*!
+   * \brief Discards everything written so far.
+   */
+  auto clear() -> void { size_ = 0; }
+
+  auto data()      const -> const char* { return data_; }
+  auto size()      const -> size_t      { return size_; }
+  auto capacity()  const -> size_t      { return capacity_; }
+  auto remaining() const -> size_t      { return capacity_ - size_; }
+  auto full()      const -> bool        { return size_ == capacity_; }
+private:
+  char*  data_;
+  size_t capacity_;
+  size_t size_;
+};
+} /* namespace tpl */
+
+#endif//buffer_hpp_20201004_093417_PDT
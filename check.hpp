@@ -0,0 +1,56 @@
+#ifndef check_hpp_20201206_093012_PDT
+#define check_hpp_20201206_093012_PDT
+
+/*
+ * A minimal harness for the `check_*` executables, which exercise the wire and file formats end to end: `CHECK`
+ * reports each failed condition with its location but carries on, so that one run shows every failure, and
+ * `check::result` gives the exit status.  Unlike `assert`, `CHECK` is evaluated whatever `NDEBUG` says.
+ */
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+namespace check
+{
+  inline auto failures() -> size_t&
+    {
+      static size_t count = 0;
+      return count;
+    }
+  inline auto report(bool passed, const char* condition, const char* file, int line) -> bool
+    {
+      if(!passed)
+      {
+        ++failures();
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+      }
+      return passed;
+    }
+  /*!
+   * \brief `EXIT_SUCCESS` if every check passed; otherwise, reports the number which failed and `EXIT_FAILURE`.
+   */
+  inline auto result() -> int
+    {
+      if(failures() != 0)
+      {
+        std::fprintf(stderr, "%zu check(s) failed\n", failures());
+        return EXIT_FAILURE;
+      }
+      return EXIT_SUCCESS;
+    }
+} /* namespace check */
+
+#define CHECK(...) ::check::report(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+/*
+ * Checks that `expression` throws an exception of type `exception_type`.
+ */
+#define CHECK_THROWS(exception_type, ...)                                                                            \
+  do                                                                                                                 \
+  {                                                                                                                  \
+    bool thrown_ = false;                                                                                            \
+    try { (void)(__VA_ARGS__); } catch(const exception_type&) { thrown_ = true; } catch(...) {}                      \
+    ::check::report(thrown_, #__VA_ARGS__ " throws " #exception_type, __FILE__, __LINE__);                           \
+  } while(false)
+
+#endif//check_hpp_20201206_093012_PDT
@@ -0,0 +1,230 @@
+/*
+ * Checks the archive file format: what `archive_writer` writes, `archive_reader` reads back byte for byte--as a
+ * whole, block by block, by message type and by sequence number--and a damaged file is rejected rather than read.
+ */
+#include "archive.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using quote          = protocol_class::Message<1, uint64_t, int64_t, uint32_t>;
+  using trade          = protocol_class::Message<2, uint64_t, tpl::varint<uint64_t>, tpl::string_ref>;
+  using note           = protocol_class::Message<3, uint64_t, std::string>;
+  using unused         = protocol_class::Message<4, uint64_t>;
+  using definition     = protocol_class::framed_definition<quote, trade, note, unused>;
+
+  constexpr uint64_t message_count = 5000;
+
+  /*
+   * A file in the temporary directory, removed when done with.
+   */
+  class temporary_file
+  {
+  public:
+    temporary_file()
+      {
+        auto directory = std::getenv("TMPDIR");
+        path_ = std::string(directory != nullptr? directory : "/tmp") + "/check_archive_XXXXXX";
+        auto fd = ::mkstemp(&path_[0]);
+        if(fd < 0)
+        {
+          throw std::runtime_error("cannot create temporary file");
+        }
+        ::close(fd);
+      }
+    ~temporary_file()
+      {
+        ::unlink(path_.c_str());
+      }
+    auto path() const -> const std::string& { return path_; }
+
+    auto contents() const -> std::string
+      {
+        std::ifstream in(path_, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      }
+    auto replace(const std::string& contents) const -> void
+      {
+        std::ofstream out(path_, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+      }
+  private:
+    std::string path_;
+  };
+
+  /*
+   * Writes `message_count` messages (with small blocks, so that there are many), and returns each one's encoding.
+   */
+  auto write_archive(const std::string& path) -> std::vector<std::string>
+    {
+      static const std::string        text(64, 'x');
+      std::vector<std::string>        frames;
+      tpl::archive_writer<definition> writer(path, 256);
+      for(uint64_t i = 0; i < message_count; ++i)
+      {
+        switch(i % 4)
+        {
+          case 1:
+          {
+            trade m { cpp::make_tuple(i, tpl::varint<uint64_t>(i * i), tpl::string_ref(text.data(), i % 64)) };
+            writer.write(m);
+            frames.push_back(definition::serialize(m));
+            break;
+          }
+          case 3:
+          {
+            note m { cpp::make_tuple(i, text.substr(0, i % 29)) };
+            writer.write(m);
+            frames.push_back(definition::serialize(m));
+            break;
+          }
+          default:
+          {
+            quote m { cpp::make_tuple(i, -static_cast<int64_t>(i), static_cast<uint32_t>(i * 3)) };
+            writer.write(m);
+            frames.push_back(definition::serialize(m));
+          }
+        }
+      }
+      CHECK(writer.message_count() == message_count);
+      // Closed by the destructor.
+      return frames;
+    }
+
+  /*
+   * Re-encodes each message it is given, and keeps the `string_ref` fields, which point into the reader's mapping.
+   */
+  struct reencoder
+  {
+    auto operator()(const quote& m) -> void  { definition::serialize(m, out); }
+    auto operator()(const trade& m) -> void  { definition::serialize(m, out); refs.push_back(m.get<2>()); }
+    auto operator()(const note& m) -> void   { definition::serialize(m, out); }
+    auto operator()(const unused& m) -> void { definition::serialize(m, out); }
+    std::string                  out;
+    std::vector<tpl::string_ref> refs;
+  };
+
+  auto check_round_trip() -> void
+    {
+      temporary_file file;
+      auto frames = write_archive(file.path());
+      std::string stream;
+      for(const auto& frame : frames)
+      {
+        stream += frame;
+      }
+
+      tpl::archive_reader<definition> reader(file.path());
+      CHECK(reader.message_count() == message_count);
+      CHECK(reader.block_count() > 1);
+      CHECK(std::string(reader.data(), reader.size()) == stream);
+
+      reencoder all;
+      reader.dispatch(all);
+      CHECK(all.out == stream);
+      for(size_t i = 0; i < all.refs.size(); ++i)
+      {
+        CHECK(all.refs[i].size() == (i * 4 + 1) % 64 && (all.refs[i].empty() || all.refs[i][0] == 'x'));
+      }
+
+      // Each block holds whole frames.
+      auto bounds = reader.boundaries();
+      CHECK(bounds.size() == reader.block_count() + 1);
+      CHECK(bounds.front() == 0 && bounds.back() == reader.size());
+      reencoder blocks;
+      for(size_t b = 0; b + 1 < bounds.size(); ++b)
+      {
+        definition::dispatch(reader.data() + bounds[b], bounds[b + 1] - bounds[b], blocks);
+      }
+      CHECK(blocks.out == stream);
+
+      // By type: exactly that type's messages, in order.
+      std::string notes;
+      for(uint64_t i = 3; i < message_count; i += 4)
+      {
+        notes += frames[i];
+      }
+      reencoder only_notes;
+      reader.visit_all<note>(only_notes);
+      CHECK(only_notes.out == notes);
+      reencoder none;
+      reader.visit_all<unused>(none);
+      CHECK(none.out.empty());
+
+      // By sequence number.
+      for(uint64_t i = 0; i < message_count; ++i)
+      {
+        auto frame = reader.seek(i);
+        CHECK(std::string(frame.data(), frame.size()) == frames[i]);
+      }
+      reencoder one;
+      reader.read(message_count - 1, one);
+      CHECK(one.out == frames.back());
+      CHECK_THROWS(std::out_of_range, reader.seek(message_count));
+    }
+
+  auto check_empty() -> void
+    {
+      temporary_file file;
+      {
+        tpl::archive_writer<definition> writer(file.path());
+        writer.close();
+        CHECK_THROWS(std::logic_error, writer.write(quote {}));
+      }
+      tpl::archive_reader<definition> reader(file.path());
+      CHECK(reader.message_count() == 0);
+      CHECK(reader.block_count() == 0);
+      CHECK(reader.size() == 0);
+      CHECK_THROWS(std::out_of_range, reader.seek(0));
+    }
+
+  auto check_damaged() -> void
+    {
+      temporary_file file;
+      write_archive(file.path());
+      auto contents = file.contents();
+
+      file.replace(contents.substr(0, contents.size() - 1));
+      CHECK_THROWS(std::runtime_error, tpl::archive_reader<definition>(file.path()));
+
+      file.replace(contents.substr(0, 20));
+      CHECK_THROWS(std::runtime_error, tpl::archive_reader<definition>(file.path()));
+
+      auto bad_header = contents;
+      bad_header[0] = 'X';
+      file.replace(bad_header);
+      CHECK_THROWS(std::runtime_error, tpl::archive_reader<definition>(file.path()));
+
+      // The index offset, in the trailer, pointing past the trailer.
+      auto bad_offset = contents;
+      bad_offset[bad_offset.size() - 24 + 7] = '\x7f';
+      file.replace(bad_offset);
+      CHECK_THROWS(std::runtime_error, tpl::archive_reader<definition>(file.path()));
+
+      // The index offset, pointing into the middle of the messages.
+      auto misplaced = contents;
+      misplaced[misplaced.size() - 24] = static_cast<char>(misplaced[misplaced.size() - 24] + 1);
+      file.replace(misplaced);
+      CHECK_THROWS(std::exception, tpl::archive_reader<definition>(file.path()));
+
+      CHECK_THROWS(std::system_error, tpl::archive_reader<definition>(file.path() + ".missing"));
+    }
+} // namespace
+
+int main()
+{
+  check_round_trip();
+  check_empty();
+  check_damaged();
+  return check::result();
+}
@@ -0,0 +1,186 @@
+/*
+ * Checks `columnar_batch`: the same messages encode to the same bytes whether given as rows or as columns, each
+ * column holds its field of every message exactly as the row format encodes it, and a batch decodes back into both
+ * rows and columns equal to those encoded; a batch which is malformed, or of another type, is rejected.
+ */
+#include "columnar.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using line           = protocol_class::Message<1, short, int, long, uint8_t, double>;
+  using mixed          = protocol_class::Message<2, bool, std::string, tpl::varint<uint64_t>, tpl::zigzag<int32_t>, std::vector<int32_t>, tpl::compact_string>;
+  using size_field     = tpl::Field<tpl::varint<size_t>>;
+
+  auto make_lines(size_t count) -> std::vector<line>
+    {
+      std::vector<line> rows;
+      for(size_t i = 0; i < count; ++i)
+      {
+        rows.push_back(line { cpp::make_tuple(static_cast<short>(-static_cast<int>(i)), static_cast<int>(i * 1000), static_cast<long>(i) << 33, static_cast<uint8_t>(i), 0.25 * i) });
+      }
+      return rows;
+    }
+
+  auto make_mixed(size_t count) -> std::vector<mixed>
+    {
+      std::vector<mixed> rows;
+      for(size_t i = 0; i < count; ++i)
+      {
+        rows.push_back(mixed { cpp::make_tuple(i % 3 == 0, std::string(i % 11, 's'), tpl::varint<uint64_t>(uint64_t { 1 } << (i % 60)), tpl::zigzag<int32_t>(-static_cast<int32_t>(i) * 77),
+                                               std::vector<int32_t>(i % 5, static_cast<int32_t>(i)), tpl::compact_string(std::string(i % 4, 'c'))) });
+      }
+      return rows;
+    }
+
+  template<size_t...Is, typename MessageT>
+  auto to_columns(const std::vector<MessageT>& rows, tpl::detail::index_sequence<Is...>) -> typename tpl::columnar_batch<MessageT>::columns_type
+    {
+      typename tpl::columnar_batch<MessageT>::columns_type columns;
+      for(const auto& row : rows)
+      {
+        int expansion[] = { 0, (cpp::get<Is>(columns).push_back(cpp::get<Is>(row.fields())), 0)... };
+        (void)expansion;
+      }
+      return columns;
+    }
+
+  /*
+   * Field `I` of every row, encoded one after another as in the row format.
+   */
+  template<size_t I, typename MessageT>
+  auto row_column(const std::vector<MessageT>& rows) -> std::string
+    {
+      using field_type = tpl::Field<cpp::tuple_element_t<I, typename MessageT::field_tuple_type>>;
+      std::string column;
+      for(const auto& row : rows)
+      {
+        const auto& value = cpp::get<I>(row.fields());
+        std::string encoded(field_type::serialized_size(value), '\0');
+        auto        p = &encoded[0];
+        field_type::serialize(p, value);
+        column += encoded;
+      }
+      return column;
+    }
+
+  /*
+   * Splits `batch` into its columns, by the lengths in its header.
+   */
+  auto batch_columns(const std::string& batch, size_t column_count, size_t& rows) -> std::vector<std::string>
+    {
+      auto begin = batch.data() + 1;
+      auto end   = batch.data() + batch.size();
+      rows = size_field::deserialize(begin, end);
+      std::vector<size_t> sizes(column_count);
+      for(auto& size : sizes)
+      {
+        size = size_field::deserialize(begin, end);
+      }
+      std::vector<std::string> columns;
+      for(auto size : sizes)
+      {
+        columns.emplace_back(begin, size);
+        begin += size;
+      }
+      CHECK(begin == end);
+      return columns;
+    }
+
+  template<size_t...Is, typename MessageT>
+  auto check_layout(const std::vector<MessageT>& rows, const std::string& batch, tpl::detail::index_sequence<Is...>) -> void
+    {
+      size_t count   = 0;
+      auto   columns = batch_columns(batch, sizeof...(Is), count);
+      CHECK(static_cast<uint8_t>(batch[0]) == MessageT::message_type_id());
+      CHECK(count == rows.size());
+      int expansion[] = { 0, (CHECK(columns[Is] == row_column<Is>(rows)), 0)... };
+      (void)expansion;
+    }
+
+  template<typename MessageT>
+  auto check_round_trip(const std::vector<MessageT>& rows) -> void
+    {
+      using batch_type = tpl::columnar_batch<MessageT>;
+      using sequence   = tpl::detail::make_index_sequence<batch_type::column_count>;
+      auto columns = to_columns(rows, sequence {});
+
+      std::string from_rows;
+      std::string from_columns;
+      batch_type::serialize(rows, from_rows);
+      batch_type::serialize(columns, from_columns);
+      CHECK(from_rows == from_columns);
+      check_layout(rows, from_rows, sequence {});
+
+      // Decoded over stale contents, which must be replaced rather than added to.
+      typename batch_type::columns_type decoded_columns = to_columns(rows, sequence {});
+      std::vector<MessageT>             decoded_rows(rows.size() + 3);
+      batch_type::deserialize(from_rows, decoded_columns);
+      batch_type::deserialize(from_rows, decoded_rows);
+      CHECK(decoded_columns == columns);
+      CHECK(decoded_rows == rows);
+
+      // Batches follow one another in a stream.
+      auto stream = from_rows + from_rows;
+      auto begin  = stream.data();
+      auto end    = stream.data() + stream.size();
+      batch_type::deserialize(begin, end, decoded_rows);
+      CHECK(begin == stream.data() + from_rows.size());
+      batch_type::deserialize(begin, end, decoded_columns);
+      CHECK(begin == end);
+      CHECK(decoded_rows == rows && decoded_columns == columns);
+    }
+
+  auto check_malformed() -> void
+    {
+      using batch_type = tpl::columnar_batch<line>;
+      auto        rows = make_lines(10);
+      std::string batch;
+      batch_type::serialize(rows, batch);
+      batch_type::columns_type columns;
+      std::vector<line>        decoded;
+
+      CHECK_THROWS(std::length_error, batch_type::deserialize(batch.substr(0, batch.size() - 1), columns));
+      CHECK_THROWS(std::length_error, batch_type::deserialize(batch.substr(0, batch.size() - 1), decoded));
+      CHECK_THROWS(std::length_error, batch_type::deserialize(std::string(), decoded));
+
+      std::string other;
+      tpl::columnar_batch<mixed>::serialize(make_mixed(3), other);
+      CHECK_THROWS(std::invalid_argument, batch_type::deserialize(other, columns));
+
+      // One row too many for the fixed-width columns.
+      auto miscounted = batch;
+      ++miscounted[1];
+      CHECK_THROWS(std::length_error, batch_type::deserialize(miscounted, columns));
+      CHECK_THROWS(std::length_error, batch_type::deserialize(miscounted, decoded));
+
+      // One row too few for a variable-width column, which is then left with bytes over.
+      std::string mixed_batch;
+      tpl::columnar_batch<mixed>::serialize(make_mixed(20), mixed_batch);
+      --mixed_batch[1];
+      tpl::columnar_batch<mixed>::columns_type mixed_columns;
+      std::vector<mixed>                       mixed_rows;
+      CHECK_THROWS(std::length_error, tpl::columnar_batch<mixed>::deserialize(mixed_batch, mixed_columns));
+      CHECK_THROWS(std::length_error, tpl::columnar_batch<mixed>::deserialize(mixed_batch, mixed_rows));
+
+      auto ragged = tpl::columnar_batch<line>::columns_type();
+      cpp::get<0>(ragged).push_back(1);
+      CHECK_THROWS(std::invalid_argument, batch_type::serialize(ragged, batch));
+    }
+} // namespace
+
+int main()
+{
+  for(size_t count : { 0, 1, 2, 7, 300 })
+  {
+    check_round_trip(make_lines(count));
+    check_round_trip(make_mixed(count));
+  }
+  check_malformed();
+  return check::result();
+}
@@ -0,0 +1,187 @@
+/*
+ * Checks `delta_encoder` and `delta_decoder`: a stream of messages of several types, with fields of every kind,
+ * decodes to the same messages whatever the dictionary capacity and however the stream is divided between calls; an
+ * unchanged message takes only its ID and bitmap; `reset` begins a new stream on both sides; and a malformed stream
+ * is rejected.
+ */
+#include "delta.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using reading        = protocol_class::Message<1, int64_t, uint32_t, std::string, int32_t, uint8_t, bool>;
+  using misc           = protocol_class::Message<2, tpl::varint<uint64_t>, tpl::zigzag<int32_t>, double, std::vector<int32_t>, tpl::compact_string,
+                                                    int8_t, uint64_t, int16_t, bool>;
+  using unused         = protocol_class::Message<3, uint32_t>;
+  using definition     = protocol_class::definition<reading, misc, unused>;
+
+  /*
+   * The messages, each encoded in the row format, and the offset of the end of each in the delta encoding.
+   */
+  struct stream
+  {
+    std::string         delta;
+    std::string         rows;
+    std::vector<size_t> ends;
+  };
+
+  auto make_stream(tpl::delta_encoder<definition>& encoder) -> stream
+    {
+      const char* hosts[] = { "alpha", "beta", "gamma", "delta", "" };
+      stream      result;
+      auto add = [&](const reading& m)
+        {
+          encoder.encode(m, result.delta);
+          definition::serialize(m, result.rows);
+          result.ends.push_back(result.delta.size());
+        };
+      auto add_misc = [&](const misc& m)
+        {
+          encoder.encode(m, result.delta);
+          definition::serialize(m, result.rows);
+          result.ends.push_back(result.delta.size());
+        };
+      int64_t now = 1600000000000000000;
+      for(int i = 0; i < 200; ++i)
+      {
+        now += 1000 + i % 7;
+        add(reading { cpp::make_tuple(now, static_cast<uint32_t>(i / 10), std::string(hosts[i % 5]), -i * (i % 3), static_cast<uint8_t>(i % 4 == 0), i % 9 == 0) });
+        if(i % 4 == 1)
+        {
+          // Differences which wrap around, at the limits of each type.
+          auto big = i % 8 == 1;
+          add_misc(misc { cpp::make_tuple(tpl::varint<uint64_t>(big? std::numeric_limits<uint64_t>::max() : uint64_t { 1 } << (i % 64)),
+                                          tpl::zigzag<int32_t>(big? std::numeric_limits<int32_t>::min() : i), 0.5 * i, std::vector<int32_t>(i % 3, i),
+                                          tpl::compact_string(std::string(hosts[i % 4]) + "-host"), static_cast<int8_t>(big? -128 : 127),
+                                          big? uint64_t { 0 } : std::numeric_limits<uint64_t>::max(), static_cast<int16_t>(big? 32767 : -32768), big) });
+        }
+      }
+      return result;
+    }
+
+  /*
+   * Re-encodes each message it is given in the row format.
+   */
+  struct reencoder
+  {
+    auto operator()(const reading& m) -> void { definition::serialize(m, out); }
+    auto operator()(const misc& m) -> void    { definition::serialize(m, out); }
+    auto operator()(const unused& m) -> void  { definition::serialize(m, out); }
+    std::string out;
+  };
+
+  auto check_round_trip(size_t capacity) -> void
+    {
+      tpl::delta_encoder<definition> encoder(capacity);
+      auto                           in = make_stream(encoder);
+      CHECK(in.delta.size() < in.rows.size());
+
+      tpl::delta_decoder<definition> whole(capacity);
+      reencoder                      all;
+      whole.decode(in.delta, all);
+      CHECK(all.out == in.rows);
+
+      // A message at a time, and then in uneven runs of messages: the decoder's state carries over between calls.
+      tpl::delta_decoder<definition> piecewise(capacity);
+      reencoder                      pieces;
+      size_t                         offset = 0;
+      for(size_t i = 0; i < in.ends.size(); i += 1 + i % 5)
+      {
+        piecewise.decode(in.delta.data() + offset, in.ends[i] - offset, pieces);
+        offset = in.ends[i];
+      }
+      piecewise.decode(in.delta.data() + offset, in.delta.size() - offset, pieces);
+      CHECK(pieces.out == in.rows);
+
+      // A new stream after `reset`, on both sides, is encoded exactly as the first was.
+      encoder.reset();
+      whole.reset();
+      auto again = make_stream(encoder);
+      CHECK(again.delta == in.delta);
+      all.out.clear();
+      whole.decode(again.delta, all);
+      CHECK(all.out == in.rows);
+    }
+
+  auto check_unchanged() -> void
+    {
+      using delta_type = tpl::detail::message_delta<misc>;
+      tpl::delta_encoder<definition> encoder;
+      std::string                    out;
+      encoder.encode(misc {}, out);
+      CHECK(out.size() == 1 + delta_type::bitmap_size);
+
+      auto m = misc { cpp::make_tuple(tpl::varint<uint64_t>(5), tpl::zigzag<int32_t>(-5), 1.5, std::vector<int32_t> { 1 }, tpl::compact_string("x"),
+                                      static_cast<int8_t>(1), uint64_t { 2 }, static_cast<int16_t>(3), true) };
+      encoder.encode(m, out);
+      auto changed = out.size();
+      encoder.encode(m, out);
+      CHECK(out.size() == changed + 1 + delta_type::bitmap_size);
+      // Only the first of a repeated string is sent as a literal.
+      encoder.encode(reading { cpp::make_tuple(int64_t { 0 }, uint32_t { 0 }, std::string(40, 'r'), 0, uint8_t { 0 }, false) }, out);
+      auto literal = out.size();
+      encoder.encode(reading {}, out);
+      encoder.encode(reading { cpp::make_tuple(int64_t { 0 }, uint32_t { 0 }, std::string(40, 'r'), 0, uint8_t { 0 }, false) }, out);
+      CHECK(out.size() - literal < 10);
+
+      tpl::delta_decoder<definition> decoder;
+      reencoder                      handler;
+      decoder.decode(out, handler);
+      std::string expected;
+      definition::serialize(misc {}, expected);
+      definition::serialize(m, expected);
+      definition::serialize(m, expected);
+      definition::serialize(reading { cpp::make_tuple(int64_t { 0 }, uint32_t { 0 }, std::string(40, 'r'), 0, uint8_t { 0 }, false) }, expected);
+      definition::serialize(reading {}, expected);
+      definition::serialize(reading { cpp::make_tuple(int64_t { 0 }, uint32_t { 0 }, std::string(40, 'r'), 0, uint8_t { 0 }, false) }, expected);
+      CHECK(handler.out == expected);
+    }
+
+  auto check_malformed() -> void
+    {
+      reencoder handler;
+      auto decode = [&](const std::string& s)
+        {
+          tpl::delta_decoder<definition> decoder;
+          decoder.decode(s, handler);
+        };
+      // An ID which matches no message type.
+      CHECK_THROWS(std::invalid_argument, decode(std::string("\x7f", 1)));
+      // A bit for a seventh field of a six-field message.
+      CHECK_THROWS(std::invalid_argument, decode(std::string("\x01\x40", 2)));
+      // A reference to a string never sent.
+      CHECK_THROWS(std::invalid_argument, decode(std::string("\x01\x04\x03", 3)));
+      // Cut off within the bitmap, a delta and a literal string.
+      CHECK_THROWS(std::length_error, decode(std::string("\x02\x01", 2)));
+      CHECK_THROWS(std::length_error, decode(std::string("\x01\x01", 2)));
+      CHECK_THROWS(std::length_error, decode(std::string("\x01\x04\x00\x05" "abc", 7)));
+
+      // A decoder which failed may be reset and reused.
+      tpl::delta_encoder<definition> encoder;
+      auto                           in = make_stream(encoder);
+      tpl::delta_decoder<definition> decoder;
+      CHECK_THROWS(std::invalid_argument, decoder.decode(in.delta + '\x7f', handler));
+      decoder.reset();
+      handler.out.clear();
+      decoder.decode(in.delta, handler);
+      CHECK(handler.out == in.rows);
+    }
+} // namespace
+
+int main()
+{
+  // Capacities which the stream's strings fill, overflow, and fit.
+  for(size_t capacity : { 0, 1, 3, 4096 })
+  {
+    check_round_trip(capacity);
+  }
+  check_unchanged();
+  check_malformed();
+  return check::result();
+}
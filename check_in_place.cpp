@@ -0,0 +1,99 @@
+/*
+ * Checks decoding into reused per-type messages (`definition::slot_decoder` and `visitor`), framed and unframed: each
+ * delivers the same messages as decoding into fresh ones (`definition::dispatch`), and once warmed up on a stream,
+ * decodes it again without a single heap allocation.  Allocations are counted with a replaced global `operator new`
+ * (see `bench_allocations.hpp`).
+ */
+#include "protocol.hpp"
+#include "bench_allocations.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using order          = protocol_class::Message<1, uint64_t, std::string, int64_t, std::vector<int32_t>>;
+  using text           = protocol_class::Message<2, tpl::compact_string, std::vector<std::string>>;
+  using heartbeat      = protocol_class::Message<3, uint64_t>;
+  using definition     = protocol_class::definition<order, text, heartbeat>;
+  using framed         = protocol_class::framed_definition<order, text, heartbeat>;
+
+  constexpr size_t message_count = 4000;
+
+  struct checksum
+  {
+    auto operator()(const order& m) -> void     { sum += m.get<0>() + m.get<1>().size() + m.get<3>().size(); }
+    auto operator()(const text& m) -> void      { sum += m.get<0>().size() + m.get<1>().size() + m.get<1>()[0].size(); }
+    auto operator()(const heartbeat& m) -> void { sum += m.get<0>(); }
+    uint64_t sum = 0;
+  };
+
+  template<typename DefinitionT>
+  class checksum_visitor : public DefinitionT::visitor
+  {
+  public:
+    auto visit(const order& m) -> void override     { handler(m); }
+    auto visit(const text& m) -> void override      { handler(m); }
+    auto visit(const heartbeat& m) -> void override { handler(m); }
+    checksum handler;
+  };
+
+  /*
+   * Strings and sequences of varying lengths, so that the reused messages' fields must grow, and later shrink.
+   */
+  template<typename DefinitionT>
+  auto make_buffer() -> std::string
+    {
+      std::string buffer;
+      for(size_t i = 0; i < message_count; ++i)
+      {
+        switch(i % 4)
+        {
+          case 0:
+          case 1:
+            DefinitionT::serialize(order { cpp::make_tuple(uint64_t { i }, "instrument-name-" + std::to_string(i % 97), int64_t { -1 }, std::vector<int32_t>(i % 13, 7)) }, buffer);
+            break;
+          case 2:
+            DefinitionT::serialize(text { cpp::make_tuple(tpl::compact_string(std::string(i % 61, 't')), std::vector<std::string> { std::string(i % 29, 'g'), "second" }) }, buffer);
+            break;
+          default:
+            DefinitionT::serialize(heartbeat { cpp::make_tuple(uint64_t { i }) }, buffer);
+        }
+      }
+      return buffer;
+    }
+
+  template<typename DefinitionT>
+  auto check_reuse() -> void
+    {
+      auto buffer = make_buffer<DefinitionT>();
+      checksum fresh;
+      DefinitionT::dispatch(buffer, fresh);
+
+      typename DefinitionT::slot_decoder decoder;
+      checksum                           reused;
+      decoder.dispatch(buffer, reused);
+      CHECK(reused.sum == fresh.sum);
+      auto before = bench::allocation_count();
+      decoder.dispatch(buffer, reused);
+      CHECK(bench::allocation_count() == before);
+      CHECK(reused.sum == 2 * fresh.sum);
+
+      checksum_visitor<DefinitionT> visitor;
+      visitor.accept(buffer);
+      CHECK(visitor.handler.sum == fresh.sum);
+      before = bench::allocation_count();
+      visitor.accept(buffer);
+      CHECK(bench::allocation_count() == before);
+      CHECK(visitor.handler.sum == 2 * fresh.sum);
+    }
+} // namespace
+
+int main()
+{
+  check_reuse<definition>();
+  check_reuse<framed>();
+  return check::result();
+}
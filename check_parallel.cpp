@@ -0,0 +1,216 @@
+/*
+ * Checks `parallel_decoder`: every message is decoded exactly once, with per-thread handlers and with the ordered
+ * merge (which must also deliver them in input order, and decode no further ahead than its window), however many
+ * threads and chunks there are, and an empty buffer decodes to nothing; and a failure, whether in decoding or in
+ * the handler, is rethrown without leaving the decoder unusable.
+ */
+#include "parallel.hpp"
+#include "stats.hpp"
+#include "check.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using quote          = protocol_class::Message<1, uint64_t, int64_t, int64_t, uint32_t>;
+  using trade          = protocol_class::Message<2, uint64_t, tpl::varint<uint64_t>, tpl::string_ref>;
+  using note           = protocol_class::Message<3, uint64_t, std::string>;
+  using definition     = protocol_class::framed_definition<quote, trade, note>;
+  using counted        = definition::with_stats<tpl::message_stats>;
+
+  constexpr uint64_t message_count = 20000;
+
+  /*
+   * Every message carries its sequence number as its first field.
+   */
+  struct input
+  {
+    std::string         buffer;
+    std::vector<size_t> frames { 0 };   //!< The offset of every frame, and the buffer size.
+  };
+
+  auto make_input() -> input
+    {
+      input       result;
+      std::string text(40, 't');
+      for(uint64_t i = 0; i < message_count; ++i)
+      {
+        switch(i % 5)
+        {
+          case 1:
+          case 3:
+            definition::serialize(trade { cpp::make_tuple(i, tpl::varint<uint64_t>(i * 7), tpl::string_ref(text.data(), i % 40)) }, result.buffer);
+            break;
+          case 4:
+            definition::serialize(note { cpp::make_tuple(i, text.substr(0, i % 17)) }, result.buffer);
+            break;
+          default:
+            definition::serialize(quote { cpp::make_tuple(i, static_cast<int64_t>(i) * 3, -static_cast<int64_t>(i), static_cast<uint32_t>(i)) }, result.buffer);
+        }
+        result.frames.push_back(result.buffer.size());
+      }
+      return result;
+    }
+
+  /*
+   * Tallies the sequence numbers seen; `in_order` stays true while they arrive consecutively from 0.
+   */
+  struct tally
+  {
+    auto operator()(const quote& m) -> void { see(m.get<0>()); }
+    auto operator()(const trade& m) -> void { see(m.get<0>() + (m.get<2>().size() == m.get<0>() % 40? 0 : message_count)); }
+    auto operator()(const note& m) -> void  { see(m.get<0>() + (m.get<1>().size() == m.get<0>() % 17? 0 : message_count)); }
+
+    auto see(uint64_t sequence) -> void
+      {
+        in_order = in_order && sequence == count;
+        sum     += sequence;
+        ++count;
+      }
+    uint64_t count    = 0;
+    uint64_t sum      = 0;
+    bool     in_order = true;
+  };
+
+  constexpr uint64_t expected_sum = message_count * (message_count - 1) / 2;
+
+  template<typename DecoderT>
+  auto check_unordered(DecoderT& decoder, const input& in, const std::vector<size_t>& boundaries) -> void
+    {
+      std::vector<tally> handlers(decoder.thread_count());
+      decoder.decode(in.buffer.data(), in.buffer.size(), boundaries, handlers);
+      uint64_t count = 0;
+      uint64_t sum   = 0;
+      for(const auto& h : handlers)
+      {
+        count += h.count;
+        sum   += h.sum;
+      }
+      CHECK(count == message_count);
+      CHECK(sum == expected_sum);
+    }
+
+  template<typename DecoderT>
+  auto check_ordered(DecoderT& decoder, const input& in, const std::vector<size_t>& boundaries) -> void
+    {
+      tally handler;
+      decoder.decode_ordered(in.buffer.data(), in.buffer.size(), boundaries, handler);
+      CHECK(handler.count == message_count);
+      CHECK(handler.sum == expected_sum);
+      CHECK(handler.in_order);
+    }
+
+  auto decoded_so_far() -> uint64_t
+    {
+      uint64_t decoded = 0;
+      for(const auto& type : counted::stats().snapshot().types)
+      {
+        decoded += type.messages;
+      }
+      return decoded;
+    }
+
+  /*
+   * Notes how far the decoders, as counted by the stats policy, get ahead of the merge.
+   */
+  struct look_ahead
+  {
+    template<typename MessageT>
+    auto operator()(const MessageT&) -> void
+      {
+        ++replayed;
+        furthest = std::max(furthest, decoded_so_far() - before - replayed);
+      }
+    uint64_t before   = decoded_so_far();
+    uint64_t replayed = 0;
+    uint64_t furthest = 0;
+  };
+
+  /*
+   * With a chunk per message, the merge is never more than the window's worth of messages behind the decoders.
+   */
+  auto check_look_ahead(size_t threads, const input& in) -> void
+    {
+      tpl::parallel_decoder<counted> decoder(threads);
+      look_ahead                     handler;
+      decoder.decode_ordered(in.buffer.data(), in.buffer.size(), in.frames, handler);
+      CHECK(handler.replayed == message_count);
+      CHECK(handler.furthest < threads * tpl::parallel_decoder<counted>::look_ahead_per_thread);
+    }
+
+  template<typename DecoderT>
+  auto check_failures(DecoderT& decoder, const input& in) -> void
+    {
+      // A quote frame too short for its fields, a third of the way in.
+      auto third     = in.frames[in.frames.size() / 3];
+      auto malformed = in.buffer.substr(0, third) + std::string("\x01\x02xy", 4) + in.buffer.substr(third);
+      tally              handler;
+      std::vector<tally> handlers(decoder.thread_count());
+      CHECK_THROWS(std::length_error, decoder.decode_ordered(malformed, handler));
+      CHECK_THROWS(std::length_error, decoder.decode(malformed, handlers));
+
+      struct failing
+      {
+        auto operator()(const quote& m) -> void { fail(m.get<0>()); }
+        auto operator()(const trade& m) -> void { fail(m.get<0>()); }
+        auto operator()(const note& m) -> void  { fail(m.get<0>()); }
+        auto fail(uint64_t sequence) -> void
+          {
+            if(sequence == message_count / 2)
+            {
+              throw std::runtime_error("handler failed");
+            }
+          }
+      };
+      CHECK_THROWS(std::runtime_error, decoder.decode_ordered(in.buffer, failing {}));
+      std::vector<failing> failing_handlers(decoder.thread_count());
+      CHECK_THROWS(std::runtime_error, decoder.decode(in.buffer, failing_handlers));
+    }
+
+  /*
+   * An empty buffer decodes to nothing, as it does serially.
+   */
+  template<typename DecoderT>
+  auto check_empty(DecoderT& decoder) -> void
+    {
+      std::string        empty;
+      tally              handler;
+      std::vector<tally> handlers(decoder.thread_count());
+      CHECK(decoder.boundaries(empty.data(), empty.size()) == (std::vector<size_t> { 0, 0 }));
+      decoder.decode_ordered(empty, handler);
+      decoder.decode(empty, handlers);
+      CHECK(handler.count == 0);
+      for(const auto& h : handlers)
+      {
+        CHECK(h.count == 0);
+      }
+    }
+} // namespace
+
+int main()
+{
+  auto in = make_input();
+  for(size_t threads : { 1, 2, 3, 4, 8 })
+  {
+    tpl::parallel_decoder<definition> decoder(threads);
+    // Repeated, to reuse the pool across runs; with a chunk per message, so that the deques grow and are stolen from.
+    for(int r = 0; r < 3; ++r)
+    {
+      check_unordered(decoder, in, decoder.boundaries(in.buffer.data(), in.buffer.size()));
+      check_unordered(decoder, in, in.frames);
+      check_ordered(decoder, in, decoder.boundaries(in.buffer.data(), in.buffer.size()));
+      check_ordered(decoder, in, in.frames);
+    }
+    check_empty(decoder);
+    check_failures(decoder, in);
+    // Still usable after failing.
+    check_unordered(decoder, in, in.frames);
+    check_ordered(decoder, in, in.frames);
+    check_look_ahead(threads, in);
+  }
+  return check::result();
+}
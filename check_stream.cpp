@@ -0,0 +1,168 @@
+/*
+ * Checks `definition::stream_decoder`: a stream of messages of every kind of field, split into chunks at every
+ * possible point (and fed a byte at a time), must decode to the same messages as the whole stream, whether framed or
+ * not; and an unknown ID must be reported without leaving the decoder unusable.
+ */
+#include "protocol.hpp"
+#include "check.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+  using text           = protocol_class::Message<1, std::string, tpl::string_ref, tpl::compact_string>;
+  using line           = protocol_class::Message<2, short, int, long, uint8_t>;
+  using numbers        = protocol_class::Message<3, std::vector<int32_t>, tpl::varint<uint64_t>, tpl::zigzag<int32_t>, double>;
+  using flag           = protocol_class::Message<4, bool>;
+  using extra          = protocol_class::Message<9, uint32_t>;
+
+  using definition        = protocol_class::definition<text, line, numbers, flag>;
+  using framed_definition = protocol_class::framed_definition<text, line, numbers, flag>;
+  using newer_definition  = protocol_class::framed_definition<text, line, numbers, flag, extra>;
+
+  /*
+   * Re-encodes each message it visits, so that the decoded stream can be compared with the original byte for byte; a
+   * `string_ref` field is only valid during `visit`, so it must be encoded there.
+   */
+  template<typename DefinitionT>
+  class reencoder : public DefinitionT::visitor
+  {
+  public:
+    auto visit(const text& m) -> void override    { DefinitionT::serialize(m, out); }
+    auto visit(const line& m) -> void override    { DefinitionT::serialize(m, out); }
+    auto visit(const numbers& m) -> void override { DefinitionT::serialize(m, out); }
+    auto visit(const flag& m) -> void override    { DefinitionT::serialize(m, out); }
+    std::string out;
+  };
+
+  template<typename DefinitionT>
+  auto make_stream() -> std::string
+    {
+      static const std::string referenced = "referenced characters";
+      std::string stream;
+      for(int i = 0; i < 12; ++i)
+      {
+        switch(i % 4)
+        {
+          case 0:
+            DefinitionT::serialize(text { cpp::make_tuple(std::string(i * 3, 'a'), tpl::string_ref(referenced.data(), i), tpl::compact_string(std::string(i, 'c'))) }, stream);
+            break;
+          case 1:
+            DefinitionT::serialize(line { cpp::make_tuple(static_cast<short>(-i), i * 1000, -(static_cast<long>(i) << 40), static_cast<uint8_t>(i)) }, stream);
+            break;
+          case 2:
+            DefinitionT::serialize(numbers { cpp::make_tuple(std::vector<int32_t>(i, -i), tpl::varint<uint64_t>(uint64_t { 1 } << (i * 5)), tpl::zigzag<int32_t>(-i * 300), 0.5 * i) }, stream);
+            break;
+          default:
+            DefinitionT::serialize(flag { cpp::make_tuple(i % 8 == 3) }, stream);
+        }
+      }
+      return stream;
+    }
+
+  /*
+   * Feeds `stream` in chunks ending at each of `splits` (and then the rest), checking that it decodes to `expected`.
+   */
+  template<typename DefinitionT>
+  auto decode_split(const std::string& stream, const std::vector<size_t>& splits, const std::string& expected) -> bool
+    {
+      reencoder<DefinitionT>               visitor;
+      typename DefinitionT::stream_decoder decoder(visitor);
+      size_t                               offset = 0;
+      for(auto split : splits)
+      {
+        decoder.feed(stream.data() + offset, split - offset);
+        offset = split;
+      }
+      decoder.feed(stream.data() + offset, stream.size() - offset);
+      return visitor.out == expected && decoder.pending() == 0;
+    }
+
+  template<typename DefinitionT>
+  auto check_splits(const std::string& stream, const std::string& expected) -> void
+    {
+      CHECK(decode_split<DefinitionT>(stream, {}, expected));
+      for(size_t i = 0; i <= stream.size(); ++i)
+      {
+        CHECK(decode_split<DefinitionT>(stream, { i }, expected));
+      }
+      // Every pair of split points, so that a message may straddle two chunk boundaries.
+      for(size_t i = 0; i <= stream.size(); i += 3)
+      {
+        for(size_t j = i; j <= stream.size(); ++j)
+        {
+          CHECK(decode_split<DefinitionT>(stream, { i, j }, expected));
+        }
+      }
+      std::vector<size_t> every_byte;
+      for(size_t i = 1; i < stream.size(); ++i)
+      {
+        every_byte.push_back(i);
+      }
+      CHECK(decode_split<DefinitionT>(stream, every_byte, expected));
+    }
+
+  /*
+   * A message cut off by the end of a chunk is held until the rest arrives, and dropped by `reset`.
+   */
+  auto check_pending() -> void
+    {
+      auto                       stream = make_stream<definition>();
+      reencoder<definition>      visitor;
+      definition::stream_decoder decoder(visitor);
+      auto                       first  = text { cpp::make_tuple(std::string("abc"), tpl::string_ref("de"), tpl::compact_string("f")) }.serialize();
+      decoder.feed(first.data(), first.size() - 1);
+      CHECK(visitor.out.empty());
+      CHECK(decoder.pending() == first.size() - 1);
+      decoder.reset();
+      CHECK(decoder.pending() == 0);
+      decoder.feed(stream);
+      CHECK(visitor.out == stream);
+    }
+
+  /*
+   * An unknown ID in an unframed stream can't be skipped, so it throws; the decoder may then be reset and reused.
+   */
+  auto check_unknown() -> void
+    {
+      auto                       stream = make_stream<definition>();
+      reencoder<definition>      visitor;
+      definition::stream_decoder decoder(visitor);
+      CHECK_THROWS(std::invalid_argument, decoder.feed(stream + '\x7f'));
+      decoder.reset();
+      decoder.feed(stream.data(), stream.size() - 1);
+      CHECK_THROWS(std::invalid_argument, decoder.feed(stream.substr(stream.size() - 1) + '\x7f'));
+      decoder.reset();
+      visitor.out.clear();
+      decoder.feed(stream.data(), 5);
+      decoder.feed(stream.data() + 5, stream.size() - 5);
+      CHECK(visitor.out == stream);
+    }
+} // namespace
+
+int main()
+{
+  auto stream = make_stream<definition>();
+  check_splits<definition>(stream, stream);
+
+  auto framed = make_stream<framed_definition>();
+  check_splits<framed_definition>(framed, framed);
+
+  // Frames of a type unknown to the decoder are skipped, wherever the chunks are split.
+  std::string with_unknown;
+  std::string known;
+  for(uint32_t i = 0; i < 3; ++i)
+  {
+    newer_definition::serialize(extra { cpp::make_tuple(i) }, with_unknown);
+    framed_definition::serialize(line { cpp::make_tuple(static_cast<short>(i), 1, 2L, static_cast<uint8_t>(3)) }, with_unknown);
+    framed_definition::serialize(line { cpp::make_tuple(static_cast<short>(i), 1, 2L, static_cast<uint8_t>(3)) }, known);
+  }
+  check_splits<framed_definition>(with_unknown, known);
+
+  check_pending();
+  check_unknown();
+  return check::result();
+}
@@ -0,0 +1,418 @@
+#ifndef columnar_hpp_20201121_140552_PDT
+#define columnar_hpp_20201121_140552_PDT
+
+#include "protocol.hpp"
+#include "varint.hpp"
+#include <cpp/tuple.hpp>
+#include <cpp/type_traits.hpp>
+#include <cpp/cpp.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace tpl
+{
+/*********************************************************************************************************************
+* Implementation of `columnar_batch` class.
+*
+* A batch holds any number of messages of one type, stored by field rather than by message:
+*
+*   [ID][varint row count][varint byte length of each column]...[column 0][column 1]...
+*
+* where column `i` is field `i` of every message, one after another, each encoded exactly as in the row format.  Each
+* column is thus a run of values of one type--for a fixed-width field, a packed array--which compresses far better
+* than interleaved rows, and which decodes in bulk: an arithmetic column is copied into its vector as one block on a
+* little-endian host, and any other fixed-width column is checked once and then decoded value by value at constant
+* offsets.  Because every value is encoded as in the row format, a batch converts to and from rows losslessly.
+*********************************************************************************************************************/
+  namespace detail {
+
+      /*!
+       * \brief Encodes and decodes a column of values of field type `T`.
+       */
+      template<typename T>
+      class column_codec
+      {
+        using field_type  = Field<T>;
+        using bulk_tag    = std::integral_constant<bool, std::is_arithmetic<T>::value && !cpp::is_same<T, bool>::value
+                                                       && host_endianness == endianness::little>;
+        using fixed_tag   = std::integral_constant<bool, field_type::is_fixed_width>;
+        using bulk        = std::true_type;
+        using elementwise = std::false_type;
+
+        template<typename VectorT>
+        static auto serialize(char*& out, const VectorT& column, bulk) -> void
+          {
+            if(!column.empty())
+            {
+              std::memcpy(out, column.data(), sizeof(T) * column.size());
+              out += sizeof(T) * column.size();
+            }
+          }
+        template<typename VectorT>
+        static auto serialize(char*& out, const VectorT& column, elementwise) -> void
+          {
+            for(const auto& value : column)
+            {
+              field_type::serialize(out, value);
+            }
+          }
+        template<typename VectorT>
+        static auto deserialize(const char* begin, const char* end, size_t rows, VectorT& column, bulk) -> void
+          {
+            column.resize(rows);
+            if(rows != 0)
+            {
+              std::memcpy(column.data(), begin, sizeof(T) * rows);
+            }
+          }
+        template<typename VectorT>
+        static auto deserialize(const char* begin, const char* end, size_t rows, VectorT& column, elementwise) -> void
+          {
+            column.resize(rows);
+            deserialize_values(begin, end, column.begin(), column.end(), fixed_tag {});
+          }
+        /*
+         * The column's length was checked against the row count up front, so each value is decoded from a range of
+         * exactly its own size--a check the compiler folds away.
+         */
+        template<typename IteratorT>
+        static auto deserialize_values(const char* begin, const char* end, IteratorT first, IteratorT last, std::true_type) -> void
+          {
+            for(; first != last; ++first, begin += field_type::fixed_size)
+            {
+              auto p = begin;
+              *first = field_type::deserialize(p, p + field_type::fixed_size);
+            }
+          }
+        template<typename IteratorT>
+        static auto deserialize_values(const char* begin, const char* end, IteratorT first, IteratorT last, std::false_type) -> void
+          {
+            for(; first != last; ++first)
+            {
+              deserialize_value(begin, end, *first);
+            }
+            if(begin != end)
+            {
+              throw_error<std::length_error>("column length does not match its values");
+            }
+          }
+        static auto deserialize_value(const char*& begin, const char* end, T& target) -> void
+          {
+            detail::deserialize_into<field_type>(begin, end, target);
+          }
+        /*
+         * `std::vector<bool>` hands out proxies rather than references.
+         */
+        template<typename ReferenceT>
+        static auto deserialize_value(const char*& begin, const char* end, ReferenceT&& target) -> void
+          {
+            target = field_type::deserialize(begin, end);
+          }
+      public:
+        /*!
+         * \brief The encoded size of `column`.
+         */
+        template<typename VectorT>
+        static auto serialized_size(const VectorT& column) -> size_t
+          {
+            if(field_type::is_fixed_width)
+            {
+              return column.size() * field_type::fixed_size;
+            }
+            size_t size = 0;
+            for(const auto& value : column)
+            {
+              size += field_type::serialized_size(value);
+            }
+            return size;
+          }
+        /*!
+         * \brief The encoded size of the column of field `I` of each of `rows`.
+         */
+        template<size_t I, typename RowVectorT>
+        static auto serialized_size_rows(const RowVectorT& rows) -> size_t
+          {
+            if(field_type::is_fixed_width)
+            {
+              return rows.size() * field_type::fixed_size;
+            }
+            size_t size = 0;
+            for(const auto& row : rows)
+            {
+              size += field_type::serialized_size(cpp::get<I>(row.fields()));
+            }
+            return size;
+          }
+        template<typename VectorT>
+        static auto serialize(char*& out, const VectorT& column) -> void
+          {
+            serialize(out, column, bulk_tag {});
+          }
+        /*!
+         * \brief Decodes the column `[begin, end)` of `rows` values into `column`, reusing its capacity.
+         */
+        template<typename VectorT>
+        static auto deserialize(const char* begin, const char* end, size_t rows, VectorT& column) -> void
+          {
+            check_length(begin, end, rows);
+            deserialize(begin, end, rows, column, bulk_tag {});
+          }
+        /*!
+         * \brief Decodes the next value of the column ending at `end` into `target`; the column's length must have been
+         *        checked with `check_length`.
+         */
+        template<typename TargetT>
+        static auto deserialize_one(const char*& begin, const char* end, TargetT& target) -> void
+          {
+            deserialize_one(begin, end, target, fixed_tag {});
+          }
+        /*
+         * A fixed-width column is exactly `rows` values long; any other needs at least a byte per value--which also
+         * bounds the memory a corrupt row count can make the decoder allocate.
+         */
+        static auto check_length(const char* begin, const char* end, size_t rows) -> void
+          {
+            auto size = static_cast<size_t>(end - begin);
+            auto fits = field_type::is_fixed_width? rows * field_type::fixed_size == size && (field_type::fixed_size == 0 || rows <= size) : rows <= size;
+            if(!fits)
+            {
+              throw_error<std::length_error>("column length does not match its values");
+            }
+          }
+      private:
+        template<typename TargetT>
+        static auto deserialize_one(const char*& begin, const char* end, TargetT& target, std::true_type) -> void
+          {
+            auto p = begin;
+            target = field_type::deserialize(p, p + field_type::fixed_size);
+            begin += field_type::fixed_size;
+          }
+        template<typename TargetT>
+        static auto deserialize_one(const char*& begin, const char* end, TargetT& target, std::false_type) -> void
+          {
+            deserialize_value(begin, end, target);
+          }
+      };
+  } /* namespace detail */
+
+  /*!
+   * \brief Encodes batches of messages of type `MessageT` column by column; see above.  Columns may be given either
+   *        as messages (rows), or as a tuple of one vector per field (`columns_type`), and decoded into either.
+   */
+  template<typename MessageT>
+  class columnar_batch
+  {
+    using field_tuple = typename MessageT::field_tuple_type;
+    using size_field  = Field<varint<size_t>>;
+    using sequence    = detail::make_index_sequence<cpp::tuple_size<field_tuple>::value>;
+
+    template<size_t I>
+      using field_type = cpp::tuple_element_t<I, field_tuple>;
+    template<size_t I>
+      using codec_type = detail::column_codec<field_type<I>>;
+
+    template<typename SequenceT>
+    struct columns_of;
+
+    template<size_t...Is>
+    struct columns_of<detail::index_sequence<Is...>>
+    {
+      using type = cpp::tuple<std::vector<field_type<Is>>...>;
+    };
+    static_assert(cpp::tuple_size<field_tuple>::value != 0, "A columnar batch requires a message type with fields.");
+  public:
+    using message_type = MessageT;
+    using columns_type = typename columns_of<sequence>::type;
+
+    static constexpr size_t column_count = cpp::tuple_size<field_tuple>::value;
+
+    /*!
+     * \brief Appends a batch of the messages in `rows` to `out`.
+     */
+    static auto serialize(const std::vector<MessageT>& rows, cpp::string& out) -> void
+      {
+        std::array<size_t, column_count> sizes;
+        row_sizes(rows, sizes, sequence {});
+        auto p = prepare(out, rows.size(), sizes);
+        serialize_rows(p, sizes, rows, sequence {});
+      }
+    /*!
+     * \brief Appends a batch of the messages held in `columns`, whose vectors must all be of the same length.
+     */
+    static auto serialize(const columns_type& columns, cpp::string& out) -> void
+      {
+        auto rows = cpp::get<0>(columns).size();
+        std::array<size_t, column_count> sizes;
+        column_sizes(columns, sizes, sequence {});
+        if(!same_length(columns, rows, sequence {}))
+        {
+          detail::throw_error<std::invalid_argument>("columns differ in length");
+        }
+        auto p = prepare(out, rows, sizes);
+        serialize_columns(p, columns, sequence {});
+      }
+    /*!
+     * \brief Decodes the batch at `begin` into `columns`, replacing their contents but reusing their capacity, and
+     *        advances `begin` past it.
+     */
+    static auto deserialize(const char*& begin, const char* end, columns_type& columns) -> void
+      {
+        std::array<const char*, column_count + 1> bounds;
+        auto rows = read_header(begin, end, bounds);
+        deserialize_columns(bounds, rows, columns, sequence {});
+        begin = bounds.back();
+      }
+    /*!
+     * \brief Decodes the batch at `begin` into `rows`, one message per row, reusing the messages already there, and
+     *        advances `begin` past it.
+     */
+    static auto deserialize(const char*& begin, const char* end, std::vector<MessageT>& rows) -> void
+      {
+        std::array<const char*, column_count + 1> bounds;
+        auto count = read_header(begin, end, bounds);
+        deserialize_rows(bounds, count, rows, sequence {});
+        begin = bounds.back();
+      }
+    static auto deserialize(const cpp::string& s, columns_type& columns) -> void
+      {
+        auto begin = s.data();
+        deserialize(begin, begin + s.size(), columns);
+      }
+    static auto deserialize(const cpp::string& s, std::vector<MessageT>& rows) -> void
+      {
+        auto begin = s.data();
+        deserialize(begin, begin + s.size(), rows);
+      }
+  private:
+    static auto prepare(cpp::string& out, size_t rows, const std::array<size_t, column_count>& sizes) -> char*
+      {
+        auto size = 1 + size_field::serialized_size(rows);
+        for(auto column_size : sizes)
+        {
+          size += size_field::serialized_size(column_size) + column_size;
+        }
+        auto offset = out.size();
+        out.resize(offset + size);
+        auto p = &out[offset];
+        *p++ = static_cast<char>(MessageT::message_type_id());
+        size_field::serialize(p, rows);
+        for(auto column_size : sizes)
+        {
+          size_field::serialize(p, column_size);
+        }
+        return p;
+      }
+    /*
+     * Reads the header, checks that the columns fit, and returns the row count; `bounds[i]` is set to the start of
+     * column `i`, and `bounds[column_count]` to the end of the batch.
+     */
+    static auto read_header(const char* begin, const char* end, std::array<const char*, column_count + 1>& bounds) -> size_t
+      {
+        if(begin >= end)
+        {
+          detail::throw_error<std::length_error>("read past end");
+        }
+        if(*begin++ != static_cast<char>(MessageT::message_type_id()))
+        {
+          detail::throw_error<std::invalid_argument>("columnar batch holds another message type");
+        }
+        auto rows = static_cast<size_t>(size_field::deserialize(begin, end));
+        std::array<size_t, column_count> sizes;
+        for(auto& size : sizes)
+        {
+          size = static_cast<size_t>(size_field::deserialize(begin, end));
+        }
+        for(size_t i = 0; i < column_count; ++i)
+        {
+          if(static_cast<size_t>(end - begin) < sizes[i])
+          {
+            detail::throw_error<std::length_error>("encoded column length greater than remaining stream length");
+          }
+          bounds[i] = begin;
+          begin    += sizes[i];
+        }
+        bounds[column_count] = begin;
+        return rows;
+      }
+    template<size_t...Is>
+    static auto row_sizes(const std::vector<MessageT>& rows, std::array<size_t, column_count>& sizes, detail::index_sequence<Is...>) -> void
+      {
+        int expansion[] = { 0, (sizes[Is] = codec_type<Is>::template serialized_size_rows<Is>(rows), 0)... };
+        (void)expansion;
+      }
+    template<size_t...Is>
+    static auto column_sizes(const columns_type& columns, std::array<size_t, column_count>& sizes, detail::index_sequence<Is...>) -> void
+      {
+        int expansion[] = { 0, (sizes[Is] = codec_type<Is>::serialized_size(cpp::get<Is>(columns)), 0)... };
+        (void)expansion;
+      }
+    template<size_t...Is>
+    static auto same_length(const columns_type& columns, size_t rows, detail::index_sequence<Is...>) -> bool
+      {
+        bool same = true;
+        int expansion[] = { 0, (same = same && cpp::get<Is>(columns).size() == rows, 0)... };
+        (void)expansion;
+        return same;
+      }
+    /*
+     * Messages are encoded in a single pass over them, each field to the end of its own column.
+     */
+    template<size_t...Is>
+    static auto serialize_rows(char* p, const std::array<size_t, column_count>& sizes, const std::vector<MessageT>& rows, detail::index_sequence<Is...>) -> void
+      {
+        std::array<char*, column_count> cursors;
+        for(size_t i = 0; i < column_count; ++i)
+        {
+          cursors[i] = p;
+          p         += sizes[i];
+        }
+        for(const auto& row : rows)
+        {
+          int expansion[] = { 0, (Field<field_type<Is>>::serialize(cursors[Is], cpp::get<Is>(row.fields())), 0)... };
+          (void)expansion;
+        }
+      }
+    template<size_t...Is>
+    static auto serialize_columns(char* p, const columns_type& columns, detail::index_sequence<Is...>) -> void
+      {
+        int expansion[] = { 0, (codec_type<Is>::serialize(p, cpp::get<Is>(columns)), 0)... };
+        (void)expansion;
+      }
+    template<size_t...Is>
+    static auto deserialize_columns(const std::array<const char*, column_count + 1>& bounds, size_t rows, columns_type& columns, detail::index_sequence<Is...>) -> void
+      {
+        int expansion[] = { 0, (codec_type<Is>::deserialize(bounds[Is], bounds[Is + 1], rows, cpp::get<Is>(columns)), 0)... };
+        (void)expansion;
+      }
+    /*
+     * Likewise, messages are decoded in a single pass, each field from the front of its own column.
+     */
+    template<size_t...Is>
+    static auto deserialize_rows(const std::array<const char*, column_count + 1>& bounds, size_t count, std::vector<MessageT>& rows, detail::index_sequence<Is...>) -> void
+      {
+        int checks[] = { 0, (codec_type<Is>::check_length(bounds[Is], bounds[Is + 1], count), 0)... };
+        (void)checks;
+        rows.resize(count);
+        std::array<const char*, column_count> cursors;
+        std::copy(bounds.begin(), bounds.end() - 1, cursors.begin());
+        for(auto& row : rows)
+        {
+          int expansion[] = { 0, (codec_type<Is>::deserialize_one(cursors[Is], bounds[Is + 1], cpp::get<Is>(row.fields())), 0)... };
+          (void)expansion;
+        }
+        for(size_t i = 0; i < column_count; ++i)
+        {
+          if(cursors[i] != bounds[i + 1])
+          {
+            detail::throw_error<std::length_error>("column length does not match its values");
+          }
+        }
+      }
+  };
+} /* namespace tpl */
+
+#endif//columnar_hpp_20201121_140552_PDT
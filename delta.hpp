@@ -0,0 +1,502 @@
+#ifndef delta_hpp_20201128_093114_PDT
+#define delta_hpp_20201128_093114_PDT
+
+#include "protocol.hpp"
+#include "varint.hpp"
+#include "string_ref.hpp"
+#include <cpp/tuple.hpp>
+#include <cpp/type_traits.hpp>
+#include <cpp/cpp.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace tpl
+{
+/*********************************************************************************************************************
+* Implementation of `delta_encoder` and `delta_decoder` classes.
+*
+* A stateful encoding for streams which send the same message types over and over.  Each side keeps the last message
+* of each type, and a message is encoded relative to the previous one of its type:
+*
+*   [ID][presence bitmap: one bit per field, least significant bit of the first byte first][changed fields]...
+*
+* Only the fields whose bits are set follow, each encoded according to its type:
+*
+*   - an integer (or `varint`, or `zigzag`) is sent as the zigzag `varint` of its difference from the previous value,
+*     modulo its range--so a counter or timestamp which creeps upward takes a byte or two;
+*   - a `bool` takes nothing at all: its bit says that it flipped;
+*   - a string is sent as a `varint` tag: 0 for a literal, which follows as a `varint` length and its characters and
+*     is added to a dictionary shared by all string fields, or `n` for the dictionary's `n - 1`th entry;
+*   - any other field is sent whole, as in the row format.
+*
+* The first message of each type is encoded relative to a default-constructed one.  Since every message depends upon
+* those before it, a stream must be decoded from its start, in order, by a decoder created with the same dictionary
+* capacity as the encoder; and since the encoding carries no frames, an ID which matches no message type is an error.
+*********************************************************************************************************************/
+  namespace detail {
+
+      /*!
+       * \brief FNV-1a, over the referenced characters.
+       */
+      struct string_ref_hash
+      {
+        auto operator()(const string_ref& s) const -> size_t
+          {
+            uint64_t hash = 14695981039346656037ull;
+            for(auto c : s)
+            {
+              hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+          }
+      };
+      /*!
+       * \brief The encoder's side of the string dictionary: the reference for each string added, until `capacity`
+       *        strings have been.  Strings are looked up by `string_ref`, into the dictionary's own copies, so that a
+       *        lookup copies nothing.
+       */
+      class string_index
+      {
+      public:
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        explicit string_index(size_t capacity)
+          : capacity_(capacity)
+          {}
+        /*!
+         * \brief The reference of the string at `data`, if it has been added; otherwise `npos`, having added it if
+         *        there is room.
+         */
+        auto find_or_add(const char* data, size_t size) -> size_t
+          {
+            auto found = references_.find(string_ref(data, size));
+            if(found != references_.end())
+            {
+              return found->second;
+            }
+            if(entries_.size() < capacity_)
+            {
+              entries_.emplace_back(data, size);
+              references_.emplace(string_ref(entries_.back()), entries_.size() - 1);
+            }
+            return npos;
+          }
+        auto clear() -> void
+          {
+            references_.clear();
+            entries_.clear();
+          }
+      private:
+        size_t                                                  capacity_;
+        std::deque<cpp::string>                                 entries_;
+        std::unordered_map<string_ref, size_t, string_ref_hash> references_;
+      };
+      /*!
+       * \brief The decoder's side of the string dictionary: each string added, by reference.
+       */
+      class string_table
+      {
+      public:
+        explicit string_table(size_t capacity)
+          : capacity_(capacity)
+          {}
+        auto add(const char* data, size_t size) -> void
+          {
+            if(entries_.size() < capacity_)
+            {
+              entries_.emplace_back(data, size);
+            }
+          }
+        auto at(size_t reference) const -> const cpp::string&
+          {
+            if(reference >= entries_.size())
+            {
+              throw_error<std::invalid_argument>("unknown string reference");
+            }
+            return entries_[reference];
+          }
+        auto clear() -> void { entries_.clear(); }
+      private:
+        size_t                   capacity_;
+        std::vector<cpp::string> entries_;
+      };
+
+      /*!
+       * \brief Encodes an integer of unsigned type `U` as the zigzag `varint` of its difference from the previous
+       *        value, in arithmetic modulo the range of `U`.
+       */
+      template<typename U>
+      struct integer_delta
+      {
+        static auto max_size() -> size_t
+          {
+            return varint_traits<U>::max_size;
+          }
+        static auto serialize(char*& out, U value, U previous) -> void
+          {
+            auto delta = static_cast<U>(value - previous);
+            auto sign  = static_cast<U>(0 - static_cast<U>(delta >> (cpp::numeric_limits<U>::digits - 1)));
+            encode_varint(out, static_cast<U>(static_cast<U>(delta << 1) ^ sign));
+          }
+        static auto deserialize(const char*& begin, const char* end, U previous) -> U
+          {
+            auto encoded = Field<varint<U>>::deserialize(begin, end).value();
+            auto delta   = static_cast<U>((encoded >> 1) ^ static_cast<U>(0 - static_cast<U>(encoded & 1)));
+            return static_cast<U>(previous + delta);
+          }
+      };
+
+      /*!
+       * \brief Encodes a changed field of type `T`; this, the general case, sends it whole.
+       */
+      template<typename T, typename EnableT = void>
+      struct delta_field
+      {
+        static auto max_size(const T& value) -> size_t
+          {
+            return Field<T>::serialized_size(value);
+          }
+        static auto serialize(char*& out, const T& value, const T& previous, string_index&) -> void
+          {
+            Field<T>::serialize(out, value);
+          }
+        static auto deserialize(const char*& begin, const char* end, T& value, string_table&) -> void
+          {
+            deserialize_into<Field<T>>(begin, end, value);
+          }
+      };
+      template<typename T>
+      struct delta_field<T, cpp::enable_if_t<cpp::is_integral<T>::value && !cpp::is_same<T, bool>::value>>
+      {
+        using unsigned_type = cpp::make_unsigned_t<T>;
+        using delta_type    = integer_delta<unsigned_type>;
+
+        static auto max_size(const T&) -> size_t
+          {
+            return delta_type::max_size();
+          }
+        static auto serialize(char*& out, const T& value, const T& previous, string_index&) -> void
+          {
+            delta_type::serialize(out, static_cast<unsigned_type>(value), static_cast<unsigned_type>(previous));
+          }
+        static auto deserialize(const char*& begin, const char* end, T& value, string_table&) -> void
+          {
+            value = static_cast<T>(delta_type::deserialize(begin, end, static_cast<unsigned_type>(value)));
+          }
+      };
+      template<typename T>
+      struct delta_field<varint<T>>
+      {
+        static auto max_size(const varint<T>&) -> size_t
+          {
+            return delta_field<T>::max_size(T());
+          }
+        static auto serialize(char*& out, const varint<T>& value, const varint<T>& previous, string_index& strings) -> void
+          {
+            delta_field<T>::serialize(out, value.value(), previous.value(), strings);
+          }
+        static auto deserialize(const char*& begin, const char* end, varint<T>& value, string_table& strings) -> void
+          {
+            auto v = value.value();
+            delta_field<T>::deserialize(begin, end, v, strings);
+            value = v;
+          }
+      };
+      template<typename T>
+      struct delta_field<zigzag<T>>
+      {
+        static auto max_size(const zigzag<T>&) -> size_t
+          {
+            return delta_field<T>::max_size(T());
+          }
+        static auto serialize(char*& out, const zigzag<T>& value, const zigzag<T>& previous, string_index& strings) -> void
+          {
+            delta_field<T>::serialize(out, value.value(), previous.value(), strings);
+          }
+        static auto deserialize(const char*& begin, const char* end, zigzag<T>& value, string_table& strings) -> void
+          {
+            auto v = value.value();
+            delta_field<T>::deserialize(begin, end, v, strings);
+            value = v;
+          }
+      };
+      /*
+       * A field is only sent if it changed, so a `bool` which is sent has flipped.
+       */
+      template<>
+      struct delta_field<bool>
+      {
+        static auto max_size(const bool&) -> size_t
+          {
+            return 0;
+          }
+        static auto serialize(char*&, const bool&, const bool&, string_index&) -> void
+          {}
+        static auto deserialize(const char*&, const char*, bool& value, string_table&) -> void
+          {
+            value = !value;
+          }
+      };
+      template<typename StringT>
+      struct string_delta_field
+      {
+        using size_field = Field<varint<size_t>>;
+
+        static auto max_size(const StringT& value) -> size_t
+          {
+            return varint_traits<size_t>::max_size + size_field::serialized_size(value.size()) + value.size();
+          }
+        static auto serialize(char*& out, const StringT& value, const StringT&, string_index& strings) -> void
+          {
+            auto reference = strings.find_or_add(value.data(), value.size());
+            if(reference != string_index::npos)
+            {
+              size_field::serialize(out, reference + 1);
+              return;
+            }
+            size_field::serialize(out, 0);
+            size_field::serialize(out, value.size());
+            out += value.copy(out, value.size());
+          }
+        static auto deserialize(const char*& begin, const char* end, StringT& value, string_table& strings) -> void
+          {
+            size_t tag = size_field::deserialize(begin, end);
+            if(tag != 0)
+            {
+              const auto& entry = strings.at(tag - 1);
+              value.assign(entry.data(), entry.size());
+              return;
+            }
+            size_t size = size_field::deserialize(begin, end);
+            if(static_cast<size_t>(end - begin) < size)
+            {
+              throw_error<std::length_error>("encoded string length greater than remaining stream length");
+            }
+            value.assign(begin, size);
+            strings.add(begin, size);
+            begin += size;
+          }
+      };
+      template<typename TraitsT, typename AllocatorT>
+      struct delta_field<std::basic_string<char, TraitsT, AllocatorT>> : string_delta_field<std::basic_string<char, TraitsT, AllocatorT>>
+      {};
+      template<>
+      struct delta_field<compact_string> : string_delta_field<compact_string>
+      {};
+      /*
+       * Each side keeps every field of the last message of each type, which a `string_ref` could not outlive.
+       */
+      template<typename T>
+      struct delta_field<T, cpp::enable_if_t<cpp::is_same<T, string_ref>::value>>
+      {
+        static_assert(sizeof(T) == 0, "string_ref fields cannot be delta encoded; use cpp::string.");
+      };
+
+      /*!
+       * \brief Encodes and decodes messages of type `MessageT` relative to the previous one.
+       */
+      template<typename MessageT>
+      class message_delta
+      {
+        using field_tuple = typename MessageT::field_tuple_type;
+        using sequence    = make_index_sequence<cpp::tuple_size<field_tuple>::value>;
+
+        template<size_t I>
+          using field_type = delta_field<cpp::tuple_element_t<I, field_tuple>>;
+      public:
+        static constexpr size_t field_count  = cpp::tuple_size<field_tuple>::value;
+        static constexpr size_t bitmap_size  = (field_count + 7) / 8;
+
+        /*!
+         * \brief Appends `m`, encoded relative to `previous`, to `out`, and makes `previous` a copy of it.
+         */
+        static auto serialize(const MessageT& m, MessageT& previous, string_index& strings, cpp::string& out) -> void
+          {
+            auto offset = out.size();
+            out.resize(offset + 1 + bitmap_size + max_size(m.fields(), sequence {}));
+            auto p = &out[offset];
+            *p++ = static_cast<char>(MessageT::message_type_id());
+            auto bitmap = reinterpret_cast<uint8_t*>(p);
+            std::fill(bitmap, bitmap + bitmap_size, uint8_t(0));
+            p += bitmap_size;
+            serialize_fields(p, bitmap, m.fields(), previous.fields(), strings, sequence {});
+            out.resize(static_cast<size_t>(p - out.data()));
+          }
+        /*!
+         * \brief Updates `message` from the encoding (following the ID) at `begin`, and advances `begin` past it.
+         */
+        static auto deserialize(const char*& begin, const char* end, MessageT& message, string_table& strings) -> void
+          {
+            if(static_cast<size_t>(end - begin) < bitmap_size)
+            {
+              throw_error<std::length_error>("read past end");
+            }
+            auto bitmap = reinterpret_cast<const uint8_t*>(begin);
+            if(field_count % 8 != 0 && (bitmap[bitmap_size - 1] >> (field_count % 8)) != 0)
+            {
+              throw_error<std::invalid_argument>("presence bitmap names a field which does not exist");
+            }
+            begin += bitmap_size;
+            deserialize_fields(begin, end, bitmap, message.fields(), strings, sequence {});
+          }
+      private:
+        template<size_t...Is>
+        static auto max_size(const field_tuple& fields, index_sequence<Is...>) -> size_t
+          {
+            size_t size = 0;
+            int expansion[] = { 0, (size += field_type<Is>::max_size(cpp::get<Is>(fields)), 0)... };
+            (void)expansion;
+            return size;
+          }
+        template<size_t...Is>
+        static auto serialize_fields(char*& out, uint8_t* bitmap, const field_tuple& fields, field_tuple& previous, string_index& strings, index_sequence<Is...>) -> void
+          {
+            int expansion[] = { 0, (serialize_field<Is>(out, bitmap, fields, previous, strings), 0)... };
+            (void)expansion;
+          }
+        template<size_t I>
+        static auto serialize_field(char*& out, uint8_t* bitmap, const field_tuple& fields, field_tuple& previous, string_index& strings) -> void
+          {
+            const auto& value = cpp::get<I>(fields);
+            auto&       last  = cpp::get<I>(previous);
+            if(value == last)
+            {
+              return;
+            }
+            bitmap[I / 8] |= static_cast<uint8_t>(1u << (I % 8));
+            field_type<I>::serialize(out, value, last, strings);
+            last = value;
+          }
+        template<size_t...Is>
+        static auto deserialize_fields(const char*& begin, const char* end, const uint8_t* bitmap, field_tuple& fields, string_table& strings, index_sequence<Is...>) -> void
+          {
+            int expansion[] = { 0, ((bitmap[Is / 8] & (1u << (Is % 8))) != 0? (field_type<Is>::deserialize(begin, end, cpp::get<Is>(fields), strings), 0) : 0)... };
+            (void)expansion;
+          }
+      };
+  } /* namespace detail */
+
+  /*!
+   * \brief Encodes messages of `DefinitionT` relative to the previous message of the same type; see above.
+   */
+  template<typename DefinitionT>
+  class delta_encoder
+  {
+    using message_tuple = typename DefinitionT::message_tuple_type;
+  public:
+    /*!
+     * \brief Creates an encoder whose string dictionary holds up to `dictionary_capacity` strings; the decoder must
+     *        be created with the same capacity.
+     */
+    explicit delta_encoder(size_t dictionary_capacity = 4096)
+      : strings_(dictionary_capacity)
+      {}
+
+    /*!
+     * \brief Appends `m`, encoded relative to the previous message of its type, to `out`.
+     */
+    template<typename MessageT>
+    auto encode(const MessageT& m, cpp::string& out) -> void
+      {
+        constexpr size_t index = detail::message_index_from<static_cast<size_t>(MessageT::message_type_id()), message_tuple>::value;
+        static_assert(index != cpp::tuple_size<message_tuple>::value, "Message type is not part of this protocol definition.");
+        detail::message_delta<MessageT>::serialize(m, cpp::get<index>(previous_), strings_, out);
+      }
+    /*!
+     * \brief Forgets every message and string sent so far, to begin a new stream.
+     */
+    auto reset() -> void
+      {
+        previous_ = message_tuple();
+        strings_.clear();
+      }
+  private:
+    message_tuple        previous_;
+    detail::string_index strings_;
+  };
+
+  /*!
+   * \brief Decodes a stream written by a `delta_encoder<DefinitionT>`.
+   *
+   *        Each message is decoded into the decoder's copy of the last message of its type, which is then passed to
+   *        the handler; it remains valid until the next message of that type is decoded.  If decoding throws, that
+   *        copy may be left partly updated, and the decoder must be `reset` before it is used for another stream.
+   */
+  template<typename DefinitionT>
+  class delta_decoder
+  {
+    using message_tuple = typename DefinitionT::message_tuple_type;
+
+    template<typename HandlerT>
+      using decode_type = auto (*)(delta_decoder&, HandlerT&, const char*&, const char*) -> void;
+  public:
+    /*!
+     * \brief Creates a decoder whose string dictionary holds up to `dictionary_capacity` strings, as the encoder's.
+     */
+    explicit delta_decoder(size_t dictionary_capacity = 4096)
+      : strings_(dictionary_capacity)
+      {}
+
+    /*!
+     * \brief Decodes each message in the `size` bytes at `data`, which must end with a complete message, and passes
+     *        it to `handler`, which must be callable with a const reference to every message type.
+     */
+    template<typename HandlerT>
+    auto decode(const char* data, size_t size, HandlerT&& handler) -> void
+      {
+        using handler_type = cpp::remove_reference_t<HandlerT>;
+        auto table = decode_table<handler_type>(detail::make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+        auto begin = data;
+        auto end   = data + size;
+        while(begin < end)
+        {
+          auto id = static_cast<unsigned char>(*begin++);
+          table[id](*this, handler, begin, end);
+        }
+      }
+    template<typename HandlerT>
+    auto decode(const cpp::string& s, HandlerT&& handler) -> void
+      {
+        decode(s.data(), s.size(), cpp::forward<HandlerT>(handler));
+      }
+    /*!
+     * \brief Forgets every message and string received so far, to begin a new stream.
+     */
+    auto reset() -> void
+      {
+        messages_ = message_tuple();
+        strings_.clear();
+      }
+  private:
+    template<size_t I, typename HandlerT, cpp::enable_if_t<I != cpp::tuple_size<message_tuple>::value, int> = 0>
+    static auto decode_at(delta_decoder& self, HandlerT& handler, const char*& begin, const char* end) -> void
+      {
+        using message_type = cpp::tuple_element_t<I, message_tuple>;
+        auto& message = cpp::get<I>(self.messages_);
+        detail::message_delta<message_type>::deserialize(begin, end, message, self.strings_);
+        handler(static_cast<const message_type&>(message));
+      }
+    template<size_t I, typename HandlerT, cpp::enable_if_t<I == cpp::tuple_size<message_tuple>::value, int> = 0>
+    static auto decode_at(delta_decoder&, HandlerT&, const char*&, const char*) -> void
+      {
+        detail::throw_error<std::invalid_argument>("unknown message id");
+      }
+    template<typename HandlerT, size_t...IDs>
+    static auto decode_table(detail::index_sequence<IDs...>) -> const decode_type<HandlerT>*
+      {
+        static constexpr decode_type<HandlerT> table[] = { &decode_at<detail::message_index_from<IDs, message_tuple>::value, HandlerT>... };
+        return table;
+      }
+
+    message_tuple        messages_;
+    detail::string_table strings_;
+  };
+} /* namespace tpl */
+
+#endif//delta_hpp_20201128_093114_PDT
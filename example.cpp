@@ -82,11 +82,8 @@ int main()
   cout << stream_2.size() << ": "; print_hex(stream_2); cout << "\n";
   cout << stream_3.size() << ": "; print_hex(stream_3); cout << "\n";
 
-  string combined;
-  message_1.serialize(combined);
-  message_2.serialize(combined);
-  message_3.serialize(combined);
-  message_4.serialize(combined);
+  protocol_t::batch_encoder combined;
+  combined.encode(message_1, message_2, message_3, message_4);
 
   class A final : public protocol_visitor
   {
@@ -153,7 +150,7 @@ int main()
   };
 
   A a(message_1, message_2, message_3, message_4);
-  a.accept(combined);
+  a.accept(combined.data(), combined.size());
   return 0;
 }
 
@@ -2,13 +2,39 @@
 #define field_hpp_20200905_224327_PDT
 
 #include <string>
+#include <array>
+#include <vector>
+#include <iterator>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
+#include <cstring>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <utility>
 #include <cpp/cpp.hpp>
 #include <cpp/type_traits.hpp>
+#include "string_ref.hpp"
 
 namespace tpl {
 /*!
  * \brief The SFINAE base class!  W00t.
+ *
+ *        Each specialization provides:
+ *          - `is_fixed_width`/`fixed_size`: whether every value encodes to the same number of bytes, and if so, how
+ *            many;
+ *          - `serialized_size(value)`: the number of bytes `value` encodes to;
+ *          - `serialize(out, value)`: writes exactly `serialized_size(value)` bytes at `out`, and advances it;
+ *          - `serialize(s, value)`: appends the encoded value to a string;
+ *          - `deserialize(begin, end)`: decodes a `value_type` from the byte range `[begin, end)`, advancing `begin`
+ *            past it, and throwing `std::length_error` if the range ends first.  The range may be given either as
+ *            `const char*` pointers into any contiguous memory, or as iterators into a `cpp::string`;
+ *          - `skip(begin, end)`: advances `begin` past an encoded value without decoding it, and returns 0; or, if the
+ *            range ends first, leaves `begin` alone and returns a nonzero lower bound on the number of bytes missing;
+ *            or, if no further bytes could make the value decodable (e.g. an over-long varint), returns
+ *            `detail::skip_invalid`.  A value which skips successfully decodes without error.
  */
 template<typename FT, typename EnableT = void>
 class Field;
@@ -29,6 +55,148 @@ class Field<FT, cpp::enable_if_t<!cpp::is_same<cpp::remove_reference_t<FT>, FT>:
 {
   static_assert(cpp::is_same<FT, cpp::remove_reference_t<FT>>::value, "Field may not be a reference type.");
 };
+namespace detail {
+  /*!
+   * \brief Raises an `ExceptionT`; or, when exceptions are disabled (e.g. `-fno-exceptions`), aborts--in which case
+   *        input which may be malformed should be decoded with `definition::try_dispatch`, which checks before it
+   *        decodes.
+   */
+  template<typename ExceptionT>
+  [[noreturn]] auto throw_error(const char* what) -> void
+    {
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+      throw ExceptionT(what);
+#else
+      (void)what;
+      std::abort();
+#endif
+    }
+  /*!
+   * \brief Returned by `skip` for an encoding which is malformed, rather than merely incomplete.
+   */
+  constexpr size_t skip_invalid = static_cast<size_t>(-1);
+
+  /*!
+   * \brief Grows `s` once by the encoded size of `value`, and writes the encoded value into the new space.
+   */
+  template<typename FieldT, typename VT>
+  auto append_serialized(cpp::string& s, const VT& value) -> void
+    {
+      auto offset = s.size();
+      s.resize(offset + FieldT::serialized_size(value));
+      auto out = &s[offset];
+      FieldT::serialize(out, value);
+    }
+  /*!
+   * \brief Decodes a value from the remainder of a string by way of the `const char*` interface.
+   */
+  template<typename FieldT>
+  auto deserialize_from(cpp::string::const_iterator& begin, const cpp::string::const_iterator& end) -> typename FieldT::value_type
+    {
+      if(begin >= end)
+      {
+        detail::throw_error<std::length_error>("read past end");
+      }
+      const char* first = &*begin;
+      const char* last  = first + (end - begin);
+      const char* p     = first;
+      auto result = FieldT::deserialize(p, last);
+      begin += p - first;
+      return result;
+    }
+  template<typename FieldT, typename EnableT = void>
+  struct has_in_place_deserialize : std::false_type {};
+
+  template<typename FieldT>
+  struct has_in_place_deserialize<FieldT, decltype(FieldT::deserialize(std::declval<const char*&>(), std::declval<const char*>(), std::declval<typename FieldT::value_type&>()))>
+    : std::true_type {};
+
+  template<typename FieldT>
+  auto deserialize_into(const char*& begin, const char* end, typename FieldT::value_type& target, std::true_type) -> void
+    {
+      FieldT::deserialize(begin, end, target);
+    }
+  template<typename FieldT>
+  auto deserialize_into(const char*& begin, const char* end, typename FieldT::value_type& target, std::false_type) -> void
+    {
+      target = FieldT::deserialize(begin, end);
+    }
+  /*!
+   * \brief Decodes a value into `target`.  Fields which own heap storage (strings and sequences) provide an overload
+   *        of `deserialize` which does so in place, reusing whatever capacity `target` already has; for the rest, the
+   *        decoded value is simply assigned.
+   */
+  template<typename FieldT>
+  auto deserialize_into(const char*& begin, const char* end, typename FieldT::value_type& target) -> void
+    {
+      deserialize_into<FieldT>(begin, end, target, has_in_place_deserialize<FieldT> {});
+    }
+  template<typename FieldT, typename GatherT, typename EnableT = void>
+  struct has_gather_serialize : std::false_type {};
+
+  template<typename FieldT, typename GatherT>
+  struct has_gather_serialize<FieldT, GatherT, decltype(FieldT::serialize_gather(std::declval<GatherT&>(), std::declval<const typename FieldT::value_type&>()))>
+    : std::true_type {};
+
+  template<typename FieldT, typename GatherT>
+  auto serialize_gather(GatherT& out, const typename FieldT::value_type& value, std::true_type) -> void
+    {
+      FieldT::serialize_gather(out, value);
+    }
+  template<typename FieldT, typename GatherT>
+  auto serialize_gather(GatherT& out, const typename FieldT::value_type& value, std::false_type) -> void
+    {
+      auto p = out.prepare(FieldT::serialized_size(value));
+      FieldT::serialize(p, value);
+    }
+  /*!
+   * \brief Encodes a value into a scatter-gather writer (see `gather_buffer`).  Fields with a contiguous payload
+   *        (strings and arithmetic sequences) provide a `serialize_gather` which writes their length prefix into the
+   *        writer's scratch space, and offers the payload to be referenced in place; the rest are encoded into the
+   *        scratch space as usual.
+   */
+  template<typename FieldT, typename GatherT>
+  auto serialize_gather(GatherT& out, const typename FieldT::value_type& value) -> void
+    {
+      serialize_gather<FieldT>(out, value, has_gather_serialize<FieldT, GatherT> {});
+    }
+  /*!
+   * \brief `skip` for fields which always encode to `N` bytes.
+   */
+  template<size_t N>
+  auto skip_fixed(const char*& begin, const char* end) -> size_t
+    {
+      auto available = static_cast<size_t>(end - begin);
+      if(available < N)
+      {
+        return N - available;
+      }
+      begin += N;
+      return 0;
+    }
+  /*!
+   * \brief `skip` for fields which encode as a length (a `SizeFieldT`) followed by that many bytes.
+   */
+  template<typename SizeFieldT>
+  auto skip_length_prefixed(const char*& begin, const char* end) -> size_t
+    {
+      auto p = begin;
+      auto missing = SizeFieldT::skip(p, end);
+      if(missing != 0)
+      {
+        return missing;
+      }
+      p = begin;
+      auto size      = static_cast<size_t>(SizeFieldT::deserialize(p, end));
+      auto available = static_cast<size_t>(end - p);
+      if(available < size)
+      {
+        return size - available;
+      }
+      begin = p + size;
+      return 0;
+    }
+} /* namespace detail */
 /*!
  * \brief Boolean Field objects.
  */
@@ -37,17 +205,35 @@ class Field<bool>
 {
   using string_iter = cpp::string::const_iterator;
 public:
-  static auto serialize(cpp::string& s, bool b) -> void
+  using value_type = bool;
+
+  static constexpr bool   is_fixed_width = true;
+  static constexpr size_t fixed_size     = 1;
+
+  static constexpr auto serialized_size(bool) -> size_t { return fixed_size; }
+  static auto serialize(char*& out, bool b) -> void
     {
       constexpr char ch_true  = '\01';
       constexpr char ch_false = '\00';
-      s += (b == true? ch_true : ch_false);
+      *out++ = (b == true? ch_true : ch_false);
+    }
+  static auto serialize(cpp::string& s, bool b) -> void
+    {
+      detail::append_serialized<Field>(s, b);
     }
   static auto deserialize(string_iter& begin, const string_iter& end) -> bool
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_fixed<fixed_size>(begin, end);
+    }
+  static auto deserialize(const char*& begin, const char* end) -> bool
     {
       if(begin >= end)
       {
-        throw std::length_error("read past end");
+        detail::throw_error<std::length_error>("read past end");
       }
       auto byte = *begin;
       bool result = byte == '\00'? false : true;
@@ -55,6 +241,85 @@ public:
       return result;
     }
 };
+namespace detail {
+  /*
+   * The wire format stores integers least-significant byte first.  When the host byte order is known at compile-time,
+   * integral fields are copied as a block (and byte-swapped on big-endian hosts); otherwise, they are shifted out and
+   * in one byte at a time.  Defining `TEMPLAR_PORTABLE_ENDIAN` forces the byte-at-a-time path, which produces
+   * identical output.
+   */
+  enum class endianness { little, big, unknown };
+
+#if defined(TEMPLAR_PORTABLE_ENDIAN)
+  constexpr endianness host_endianness = endianness::unknown;
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  constexpr endianness host_endianness = endianness::little;
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  constexpr endianness host_endianness = endianness::big;
+#elif defined(_MSC_VER)
+  constexpr endianness host_endianness = endianness::little;
+#else
+  constexpr endianness host_endianness = endianness::unknown;
+#endif
+
+  template<endianness E>
+    using endianness_tag = std::integral_constant<endianness, E>;
+
+  template<size_t N>
+  struct byte_swapper;
+
+  template<>
+  struct byte_swapper<1>
+  {
+    template<typename T>
+    static auto swap(T value) -> T { return value; }
+  };
+#if defined(__GNUC__)
+  template<>
+  struct byte_swapper<2>
+  {
+    template<typename T>
+    static auto swap(T value) -> T { return __builtin_bswap16(value); }
+  };
+  template<>
+  struct byte_swapper<4>
+  {
+    template<typename T>
+    static auto swap(T value) -> T { return __builtin_bswap32(value); }
+  };
+  template<>
+  struct byte_swapper<8>
+  {
+    template<typename T>
+    static auto swap(T value) -> T { return __builtin_bswap64(value); }
+  };
+#else
+  template<size_t N>
+  struct byte_swapper
+  {
+    template<typename T>
+    static auto swap(T value) -> T
+      {
+        T result = 0;
+        for(size_t i = 0; i < N; ++i)
+        {
+          result = (result << 8) | (value & 0xFF);
+          value >>= 8;
+        }
+        return result;
+      }
+  };
+#endif
+
+  /*!
+   * \brief Converts an unsigned integer between host and wire (little-endian) byte order.
+   */
+  template<typename T>
+  auto byte_swap(T value) -> T
+    {
+      return byte_swapper<sizeof(T)>::swap(value);
+    }
+} /* namespace detail */
 /*!
  * \brief Class of Field objects which require endian conversion.
  */
@@ -63,69 +328,627 @@ class Field<FT, cpp::enable_if_t<cpp::is_integral<FT>::value>>
 {
   using string_iter       = cpp::string::const_iterator;
   using unsigned_value_t  = cpp::make_unsigned_t<FT>;
+  using little_endian     = detail::endianness_tag<detail::endianness::little>;
+  using big_endian        = detail::endianness_tag<detail::endianness::big>;
+  using unknown_endian    = detail::endianness_tag<detail::endianness::unknown>;
+  using host_endian       = detail::endianness_tag<detail::host_endianness>;
 
   template<size_t N, typename = cpp::enable_if_t<N == sizeof(FT), void>>
-  static auto endian_neutral_serialize(cpp::string& s, const unsigned_value_t& value) -> void
+  static auto endian_neutral_serialize(char*& out, const unsigned_value_t& value) -> void
     {
     }
   template<size_t N, typename = cpp::enable_if_t<N != sizeof(FT), int>>
-  static auto endian_neutral_serialize(cpp::string& s, const unsigned_value_t& value, void* = nullptr) -> void
+  static auto endian_neutral_serialize(char*& out, const unsigned_value_t& value, void* = nullptr) -> void
     {
       constexpr size_t shift_amount = N * 8;
       uint8_t ch = (value >> shift_amount);
-      s.append(1, ch);
-      endian_neutral_serialize<N + 1>(s, value); 
+      *out++ = static_cast<char>(ch);
+      endian_neutral_serialize<N + 1>(out, value); 
     }
   template<size_t N, typename = cpp::enable_if_t<N == sizeof(FT), void>>
-  static auto endian_neutral_deserialize(string_iter& begin, const string_iter& end) -> unsigned_value_t
+  static auto endian_neutral_deserialize(const char*& begin, const char* end) -> unsigned_value_t
     {
       return 0;
     }
   template<size_t N, typename = cpp::enable_if_t<N != sizeof(FT), int>>
-  static auto endian_neutral_deserialize(string_iter& begin, const string_iter& end, void* = nullptr) -> unsigned_value_t
+  static auto endian_neutral_deserialize(const char*& begin, const char* end, void* = nullptr) -> unsigned_value_t
     {
+      if(begin >= end)
+      {
+        detail::throw_error<std::length_error>("read past end");
+      }
       constexpr size_t shift_amount = N * 8;
       unsigned_value_t result = static_cast<uint8_t>(*begin); // cast to uint8_t from char necessary to avoid sign error 
                                                               // when converting to unsigned_value_t
       result <<= shift_amount;
       return result | endian_neutral_deserialize<N + 1>(++begin, end); 
     }
+
+  static auto serialize(char*& out, unsigned_value_t value, little_endian) -> void
+    {
+      std::memcpy(out, &value, sizeof(value));
+      out += sizeof(value);
+    }
+  static auto serialize(char*& out, unsigned_value_t value, big_endian) -> void
+    {
+      serialize(out, detail::byte_swap(value), little_endian{});
+    }
+  static auto serialize(char*& out, unsigned_value_t value, unknown_endian) -> void
+    {
+      endian_neutral_serialize<0>(out, value);
+    }
+  static auto deserialize(const char*& begin, const char* end, little_endian) -> unsigned_value_t
+    {
+      if(end - begin < static_cast<std::ptrdiff_t>(sizeof(unsigned_value_t)))
+      {
+        detail::throw_error<std::length_error>("read past end");
+      }
+      unsigned_value_t result;
+      std::memcpy(&result, begin, sizeof(result));
+      begin += sizeof(result);
+      return result;
+    }
+  static auto deserialize(const char*& begin, const char* end, big_endian) -> unsigned_value_t
+    {
+      return detail::byte_swap(deserialize(begin, end, little_endian{}));
+    }
+  static auto deserialize(const char*& begin, const char* end, unknown_endian) -> unsigned_value_t
+    {
+      return endian_neutral_deserialize<0>(begin, end);
+    }
 public:
+  using value_type = FT;
+
+  static constexpr bool   is_fixed_width = true;
+  static constexpr size_t fixed_size     = sizeof(FT);
+
+  static constexpr auto serialized_size(FT) -> size_t { return fixed_size; }
+  static auto serialize(char*& out, FT value) -> void
+    {
+      serialize(out, static_cast<unsigned_value_t>(value), host_endian{});
+    }
   static auto serialize(cpp::string& s, FT value) -> void
     {
-      endian_neutral_serialize<0>(s, static_cast<unsigned_value_t>(value));
+      detail::append_serialized<Field>(s, value);
     }
   static auto deserialize(string_iter& begin, const string_iter& end) -> FT
     {
-      endian_neutral_deserialize<0>(begin, end);
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_fixed<fixed_size>(begin, end);
+    }
+  static auto deserialize(const char*& begin, const char* end) -> FT
+    {
+      return static_cast<FT>(deserialize(begin, end, host_endian{}));
     }
 };
 /*!
- * \brief String Field objects.
+ * \brief Floating-point Field objects; encoded as the integral Field of the same width holding the IEEE-754 bits.
  */
-template<>
-class Field<cpp::string>
+template<typename FT>
+class Field<FT, cpp::enable_if_t<std::is_floating_point<FT>::value>>
 {
+  static_assert(cpp::numeric_limits<FT>::is_iec559 && (sizeof(FT) == 4 || sizeof(FT) == 8), "Only IEEE-754 binary32 and binary64 floating-point fields are supported.");
   using string_iter = cpp::string::const_iterator;
+  using bits_type   = typename cpp::conditional<sizeof(FT) == 4, uint32_t, uint64_t>::type;
+  using bits_field  = Field<bits_type>;
+
+  static auto to_bits(FT value) -> bits_type
+    {
+      bits_type bits;
+      std::memcpy(&bits, &value, sizeof(bits));
+      return bits;
+    }
+  static auto from_bits(bits_type bits) -> FT
+    {
+      FT value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
 public:
-  static auto serialize(cpp::string& s, const cpp::string& source) -> void
+  using value_type = FT;
+
+  static constexpr bool   is_fixed_width = true;
+  static constexpr size_t fixed_size     = sizeof(FT);
+
+  static constexpr auto serialized_size(FT) -> size_t { return fixed_size; }
+  static auto serialize(char*& out, FT value) -> void
     {
-      Field<cpp::string::size_type>::serialize(s, source.size());
-      s += source;
+      bits_field::serialize(out, to_bits(value));
     }
-  static auto deserialize(string_iter& begin, const string_iter& end) -> cpp::string
+  static auto serialize(cpp::string& s, FT value) -> void
     {
-      auto size = Field<cpp::string::size_type>::deserialize(begin, end);
-      if(end - begin < size)
+      detail::append_serialized<Field>(s, value);
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> FT
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_fixed<fixed_size>(begin, end);
+    }
+  static auto deserialize(const char*& begin, const char* end) -> FT
+    {
+      return from_bits(bits_field::deserialize(begin, end));
+    }
+};
+/*!
+ * \brief Fixed-size array Field objects; the elements are encoded back-to-back, with no length prefix.
+ *
+ *        Arrays of arithmetic (non-`bool`) elements have the same layout on the wire as in memory on a little-endian
+ *        host, so there they are copied as a single block; otherwise, elements are encoded one at a time.
+ */
+template<typename T, size_t N>
+class Field<std::array<T, N>>
+{
+  using string_iter   = cpp::string::const_iterator;
+  using element_field = Field<T>;
+  using bulk_tag      = std::integral_constant<bool, std::is_arithmetic<T>::value && !cpp::is_same<T, bool>::value
+                                                  && detail::host_endianness == detail::endianness::little && N != 0>;
+  using bulk          = std::true_type;
+  using elementwise   = std::false_type;
+
+  static auto serialize(char*& out, const std::array<T, N>& source, bulk) -> void
+    {
+      std::memcpy(out, source.data(), sizeof(T) * N);
+      out += sizeof(T) * N;
+    }
+  static auto serialize(char*& out, const std::array<T, N>& source, elementwise) -> void
+    {
+      for(const auto& element : source)
+      {
+        element_field::serialize(out, element);
+      }
+    }
+  static auto deserialize(const char*& begin, const char* end, bulk) -> std::array<T, N>
+    {
+      if(static_cast<size_t>(end - begin) < sizeof(T) * N)
+      {
+        detail::throw_error<std::length_error>("read past end");
+      }
+      std::array<T, N> result;
+      std::memcpy(result.data(), begin, sizeof(T) * N);
+      begin += sizeof(T) * N;
+      return result;
+    }
+  static auto deserialize(const char*& begin, const char* end, elementwise) -> std::array<T, N>
+    {
+      std::array<T, N> result;
+      for(auto& element : result)
+      {
+        element = element_field::deserialize(begin, end);
+      }
+      return result;
+    }
+public:
+  using value_type = std::array<T, N>;
+
+  static constexpr bool   is_fixed_width = element_field::is_fixed_width;
+  static constexpr size_t fixed_size     = element_field::fixed_size * N;
+
+  static auto serialized_size(const std::array<T, N>& source) -> size_t
+    {
+      if(is_fixed_width)
+      {
+        return fixed_size;
+      }
+      size_t size = 0;
+      for(const auto& element : source)
       {
-        throw std::length_error("encoded string length greater than remaining stream length");
+        size += element_field::serialized_size(element);
       }
-      cpp::string result;
+      return size;
+    }
+  static auto serialize(char*& out, const std::array<T, N>& source) -> void
+    {
+      serialize(out, source, bulk_tag{});
+    }
+  static auto serialize(cpp::string& s, const std::array<T, N>& source) -> void
+    {
+      detail::append_serialized<Field>(s, source);
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> std::array<T, N>
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      if(is_fixed_width)
+      {
+        return detail::skip_fixed<fixed_size>(begin, end);
+      }
+      auto p = begin;
+      for(size_t i = 0; i < N; ++i)
+      {
+        auto missing = element_field::skip(p, end);
+        if(missing != 0)
+        {
+          return missing;
+        }
+      }
+      begin = p;
+      return 0;
+    }
+  static auto deserialize(const char*& begin, const char* end) -> std::array<T, N>
+    {
+      return deserialize(begin, end, bulk_tag{});
+    }
+};
+namespace detail {
+  /*!
+   * \brief Iterates over the elements of an array of `T` laid out in a byte buffer, which need not be aligned for `T`.
+   *
+   *        Constructing a container from a range of these reads the buffer in a single pass, into storage that is
+   *        allocated once and never zero-filled.
+   */
+  template<typename T>
+  class unaligned_iterator
+  {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = T;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const T*;
+    using reference         = T;
+
+    explicit unaligned_iterator(const char* p)
+      : p_(p)
+      {}
+    auto operator*() const -> T
+      {
+        T value;
+        std::memcpy(&value, p_, sizeof(value));
+        return value;
+      }
+    auto operator[](difference_type n) const -> T { return *(*this + n); }
+    auto operator++()    -> unaligned_iterator& { p_ += sizeof(T); return *this; }
+    auto operator++(int) -> unaligned_iterator  { auto it = *this; ++*this; return it; }
+    auto operator--()    -> unaligned_iterator& { p_ -= sizeof(T); return *this; }
+    auto operator--(int) -> unaligned_iterator  { auto it = *this; --*this; return it; }
+    auto operator+=(difference_type n) -> unaligned_iterator& { p_ += n * static_cast<difference_type>(sizeof(T)); return *this; }
+    auto operator-=(difference_type n) -> unaligned_iterator& { p_ -= n * static_cast<difference_type>(sizeof(T)); return *this; }
+    auto operator+(difference_type n) const -> unaligned_iterator { auto it = *this; return it += n; }
+    auto operator-(difference_type n) const -> unaligned_iterator { auto it = *this; return it -= n; }
+    auto operator-(const unaligned_iterator& other) const -> difference_type
+      {
+        return (p_ - other.p_) / static_cast<difference_type>(sizeof(T));
+      }
+    auto operator==(const unaligned_iterator& other) const -> bool { return p_ == other.p_; }
+    auto operator!=(const unaligned_iterator& other) const -> bool { return p_ != other.p_; }
+    auto operator< (const unaligned_iterator& other) const -> bool { return p_ <  other.p_; }
+    auto operator> (const unaligned_iterator& other) const -> bool { return p_ >  other.p_; }
+    auto operator<=(const unaligned_iterator& other) const -> bool { return p_ <= other.p_; }
+    auto operator>=(const unaligned_iterator& other) const -> bool { return p_ >= other.p_; }
+  private:
+    const char* p_;
+  };
+} /* namespace detail */
+/*!
+ * \brief Variable-length sequence Field objects; a `size_t` element count, followed by the elements back-to-back.
+ *
+ *        As with `std::array`, sequences of arithmetic (non-`bool`) elements are copied as a single block on little-
+ *        endian hosts; there, decoding allocates the vector once and fills it in one pass over the input.  Other
+ *        elements--including nested sequences--are encoded one at a time.
+ */
+template<typename T, typename AllocatorT>
+class Field<std::vector<T, AllocatorT>>
+{
+  using string_iter   = cpp::string::const_iterator;
+  using sequence_type = std::vector<T, AllocatorT>;
+  using size_field    = Field<typename sequence_type::size_type>;
+  using element_field = Field<T>;
+  using bulk_tag      = std::integral_constant<bool, std::is_arithmetic<T>::value && !cpp::is_same<T, bool>::value
+                                                  && detail::host_endianness == detail::endianness::little>;
+  using bulk          = std::true_type;
+  using elementwise   = std::false_type;
+
+  static auto serialize_elements(char*& out, const sequence_type& source, bulk) -> void
+    {
+      if(!source.empty())
+      {
+        std::memcpy(out, source.data(), sizeof(T) * source.size());
+        out += sizeof(T) * source.size();
+      }
+    }
+  static auto serialize_elements(char*& out, const sequence_type& source, elementwise) -> void
+    {
+      for(const auto& element : source)
+      {
+        element_field::serialize(out, element);
+      }
+    }
+  static auto deserialize_elements(const char*& begin, const char* end, size_t size, bulk) -> sequence_type
+    {
+      if(static_cast<size_t>(end - begin) / sizeof(T) < size)
+      {
+        detail::throw_error<std::length_error>("encoded sequence length greater than remaining stream length");
+      }
+      auto first = detail::unaligned_iterator<T>(begin);
+      sequence_type result(first, first + static_cast<std::ptrdiff_t>(size));
+      begin += sizeof(T) * size;
+      return result;
+    }
+  static auto deserialize_elements(const char*& begin, const char* end, size_t size, sequence_type& target, bulk) -> void
+    {
+      if(static_cast<size_t>(end - begin) / sizeof(T) < size)
+      {
+        detail::throw_error<std::length_error>("encoded sequence length greater than remaining stream length");
+      }
+      auto first = detail::unaligned_iterator<T>(begin);
+      target.assign(first, first + static_cast<std::ptrdiff_t>(size));
+      begin += sizeof(T) * size;
+    }
+  template<typename GatherT>
+  static auto serialize_gather(GatherT& out, const sequence_type& source, bulk) -> void
+    {
+      auto p = out.prepare(size_field::fixed_size);
+      size_field::serialize(p, source.size());
+      if(!source.empty())
+      {
+        out.reference(reinterpret_cast<const char*>(source.data()), sizeof(T) * source.size());
+      }
+    }
+  template<typename GatherT>
+  static auto serialize_gather(GatherT& out, const sequence_type& source, elementwise) -> void
+    {
+      auto p = out.prepare(size_field::fixed_size);
+      size_field::serialize(p, source.size());
+      for(const auto& element : source)
+      {
+        detail::serialize_gather<element_field>(out, element);
+      }
+    }
+  static auto deserialize_element(const char*& begin, const char* end, sequence_type& target, size_t i, std::true_type) -> void
+    {
+      element_field::deserialize(begin, end, target[i]);
+    }
+  // Also serves `std::vector<bool>`, whose elements can only be assigned through a proxy.
+  static auto deserialize_element(const char*& begin, const char* end, sequence_type& target, size_t i, std::false_type) -> void
+    {
+      target[i] = element_field::deserialize(begin, end);
+    }
+  static auto deserialize_elements(const char*& begin, const char* end, size_t size, sequence_type& target, elementwise) -> void
+    {
+      // As below, but elements already in `target` are decoded into, so that nested strings and sequences keep their
+      // storage too.
+      target.resize(std::min(size, static_cast<size_t>(end - begin)));
+      for(size_t i = 0; i < size; ++i)
+      {
+        if(i < target.size())
+        {
+          deserialize_element(begin, end, target, i, detail::has_in_place_deserialize<element_field> {});
+        }
+        else
+        {
+          target.push_back(element_field::deserialize(begin, end));
+        }
+      }
+    }
+  static auto deserialize_elements(const char*& begin, const char* end, size_t size, elementwise) -> sequence_type
+    {
+      // Every element occupies at least one byte, so a count larger than the remaining input is certainly bogus; don't
+      // let it drive the reservation.
+      sequence_type result;
+      result.reserve(std::min(size, static_cast<size_t>(end - begin)));
       for(size_t i = 0; i < size; ++i)
       {
-        result += *begin;
-        ++begin;
+        result.push_back(element_field::deserialize(begin, end));
+      }
+      return result;
+    }
+public:
+  using value_type = sequence_type;
+
+  static constexpr bool   is_fixed_width = false;
+  static constexpr size_t fixed_size     = 0;
+
+  static auto serialized_size(const sequence_type& source) -> size_t
+    {
+      if(element_field::is_fixed_width)
+      {
+        return size_field::fixed_size + element_field::fixed_size * source.size();
+      }
+      size_t size = size_field::fixed_size;
+      for(const auto& element : source)
+      {
+        size += element_field::serialized_size(element);
+      }
+      return size;
+    }
+  static auto serialize(char*& out, const sequence_type& source) -> void
+    {
+      size_field::serialize(out, source.size());
+      serialize_elements(out, source, bulk_tag{});
+    }
+  static auto serialize(cpp::string& s, const sequence_type& source) -> void
+    {
+      detail::append_serialized<Field>(s, source);
+    }
+  /*!
+   * \brief As `serialize`, but a block-copied sequence is offered to be referenced in place.
+   */
+  template<typename GatherT>
+  static auto serialize_gather(GatherT& out, const sequence_type& source) -> void
+    {
+      serialize_gather(out, source, bulk_tag{});
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> sequence_type
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      auto p       = begin;
+      auto missing = size_field::skip(p, end);
+      if(missing != 0)
+      {
+        return missing;
+      }
+      p = begin;
+      auto size = static_cast<size_t>(size_field::deserialize(p, end));
+      if(element_field::is_fixed_width)
+      {
+        // A count whose size in bytes would overflow is malformed, not merely incomplete.
+        if(size > (detail::skip_invalid - 1) / (element_field::fixed_size != 0? element_field::fixed_size : 1))
+        {
+          return detail::skip_invalid;
+        }
+        auto available = static_cast<size_t>(end - p);
+        auto needed    = size * element_field::fixed_size;
+        if(available < needed)
+        {
+          return needed - available;
+        }
+        begin = p + needed;
+        return 0;
+      }
+      for(size_t i = 0; i < size; ++i)
+      {
+        missing = element_field::skip(p, end);
+        if(missing != 0)
+        {
+          return missing;
+        }
+      }
+      begin = p;
+      return 0;
+    }
+  static auto deserialize(const char*& begin, const char* end) -> sequence_type
+    {
+      auto size = static_cast<size_t>(size_field::deserialize(begin, end));
+      return deserialize_elements(begin, end, size, bulk_tag{});
+    }
+  /*!
+   * \brief Decodes into `target`, reusing its capacity.
+   */
+  static auto deserialize(const char*& begin, const char* end, sequence_type& target) -> void
+    {
+      auto size = static_cast<size_t>(size_field::deserialize(begin, end));
+      deserialize_elements(begin, end, size, target, bulk_tag{});
+    }
+};
+/*!
+ * \brief String Field objects, for `cpp::string` or a string of `char` with any other allocator (see
+ *        `arena_allocator`); the encoding is the same either way.
+ */
+template<typename TraitsT, typename AllocatorT>
+class Field<std::basic_string<char, TraitsT, AllocatorT>>
+{
+  using string_iter = cpp::string::const_iterator;
+  using size_field  = Field<cpp::string::size_type>;
+  using string_type = std::basic_string<char, TraitsT, AllocatorT>;
+public:
+  using value_type = string_type;
+
+  static constexpr bool   is_fixed_width = false;
+  static constexpr size_t fixed_size     = 0;
+
+  static auto serialized_size(const string_type& source) -> size_t
+    {
+      return size_field::fixed_size + source.size();
+    }
+  static auto serialize(char*& out, const string_type& source) -> void
+    {
+      size_field::serialize(out, source.size());
+      out += source.copy(out, source.size());
+    }
+  static auto serialize(cpp::string& s, const string_type& source) -> void
+    {
+      detail::append_serialized<Field>(s, source);
+    }
+  template<typename GatherT>
+  static auto serialize_gather(GatherT& out, const string_type& source) -> void
+    {
+      auto p = out.prepare(size_field::fixed_size);
+      size_field::serialize(p, source.size());
+      out.reference(source.data(), source.size());
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> string_type
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_length_prefixed<size_field>(begin, end);
+    }
+  /*!
+   * \brief Decodes a new string, with a default-constructed allocator.
+   */
+  static auto deserialize(const char*& begin, const char* end) -> string_type
+    {
+      string_type result;
+      deserialize(begin, end, result);
+      return result;
+    }
+  /*!
+   * \brief Decodes into `target`, reusing its capacity (and its allocator).
+   */
+  static auto deserialize(const char*& begin, const char* end, string_type& target) -> void
+    {
+      auto size = size_field::deserialize(begin, end);
+      if(static_cast<size_t>(end - begin) < size)
+      {
+        detail::throw_error<std::length_error>("encoded string length greater than remaining stream length");
+      }
+      target.assign(begin, size);
+      begin += size;
+    }
+};
+/*!
+ * \brief Non-owning string Field objects; same encoding as `cpp::string`, but decoding references the input buffer
+ *        rather than copying from it.
+ */
+template<>
+class Field<string_ref>
+{
+  using string_iter = cpp::string::const_iterator;
+  using size_field  = Field<cpp::string::size_type>;
+public:
+  using value_type = string_ref;
+
+  static constexpr bool   is_fixed_width = false;
+  static constexpr size_t fixed_size     = 0;
+
+  static auto serialized_size(const string_ref& source) -> size_t
+    {
+      return size_field::fixed_size + source.size();
+    }
+  static auto serialize(char*& out, const string_ref& source) -> void
+    {
+      size_field::serialize(out, source.size());
+      out = std::copy(source.begin(), source.end(), out);
+    }
+  static auto serialize(cpp::string& s, const string_ref& source) -> void
+    {
+      detail::append_serialized<Field>(s, source);
+    }
+  template<typename GatherT>
+  static auto serialize_gather(GatherT& out, const string_ref& source) -> void
+    {
+      auto p = out.prepare(size_field::fixed_size);
+      size_field::serialize(p, source.size());
+      out.reference(source.data(), source.size());
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> string_ref
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_length_prefixed<size_field>(begin, end);
+    }
+  static auto deserialize(const char*& begin, const char* end) -> string_ref
+    {
+      auto size = size_field::deserialize(begin, end);
+      if(static_cast<size_t>(end - begin) < size)
+      {
+        detail::throw_error<std::length_error>("encoded string length greater than remaining stream length");
       }
+      string_ref result(begin, size);
+      begin += size;
       return result;
     }
 };
@@ -146,7 +969,7 @@ public:
 //    {
 //      if(begin >= end)
 //      {
-//        throw std::length_error("read past end");
+//        detail::throw_error<std::length_error>("read past end");
 //      }
 //      FT result = *begin;
 //      ++begin;
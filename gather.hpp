@@ -0,0 +1,124 @@
+#ifndef gather_hpp_20201108_152031_PDT
+#define gather_hpp_20201108_152031_PDT
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <sys/uio.h>
+
+namespace tpl
+{
+  /*!
+   * \brief A scatter-gather encoding target, for `definition::serialize_gather`: message IDs, frame headers, length
+   *        prefixes and small fields are copied into an owned scratch buffer, while string and sequence payloads of
+   *        at least `threshold` bytes are referenced where they lie.  `iovecs` then describes the whole encoding, in
+   *        order, for `writev` or `sendmsg`.
+   *
+   *        Referenced payloads are not copied, so the messages encoded must outlive the use of the `iovec`s.  The
+   *        scratch buffer and segment list are kept across `clear`, so a warmed-up buffer allocates nothing.
+   */
+  class gather_buffer
+  {
+  public:
+    explicit gather_buffer(size_t threshold = 1024)
+      : threshold_(threshold)
+      {}
+
+    /*!
+     * \brief Appends `n` bytes of scratch space, and returns them; the pointer is only valid until the next append.
+     */
+    auto prepare(size_t n) -> char*
+      {
+        auto offset = scratch_size_;
+        if(scratch_.size() - offset < n)
+        {
+          scratch_.resize(std::max(offset + n, scratch_.size() * 2));
+        }
+        scratch_size_ += n;
+        if(!segments_.empty() && !segments_.back().external)
+        {
+          segments_.back().size += n;
+        }
+        else
+        {
+          segments_.push_back(segment { false, nullptr, offset, n });
+        }
+        size_ += n;
+        return scratch_.data() + offset;
+      }
+    /*!
+     * \brief Appends `n` bytes at `data`: by reference if there are at least `threshold()` of them, or else by copy.
+     */
+    auto reference(const char* data, size_t n) -> void
+      {
+        if(n < threshold_)
+        {
+          std::copy(data, data + n, prepare(n));
+          return;
+        }
+        segments_.push_back(segment { true, data, 0, n });
+        size_ += n;
+      }
+    /*!
+     * \brief The encoding so far, as a sequence of `iovec`s; valid until the next append or `clear`.
+     */
+    auto iovecs() -> const std::vector<struct iovec>&
+      {
+        iovecs_.clear();
+        for(auto& s : segments_)
+        {
+          auto base = s.external? s.data : scratch_.data() + s.offset;
+          iovecs_.push_back(iovec { const_cast<char*>(base), s.size });
+        }
+        return iovecs_;
+      }
+    /*!
+     * \brief Passes the encoding to `writer(const iovec*, size_t count)` (e.g. an `fd_writer`), then clears it.
+     */
+    template<typename WriterT>
+    auto flush(WriterT&& writer) -> void
+      {
+        if(size_ != 0)
+        {
+          auto& v = iovecs();
+          writer(v.data(), v.size());
+        }
+        clear();
+      }
+    auto clear() -> void
+      {
+        segments_.clear();
+        scratch_size_ = 0;
+        size_         = 0;
+      }
+    /*!
+     * \brief The total number of bytes encoded, copied or referenced.
+     */
+    auto size() const -> size_t { return size_; }
+    /*!
+     * \brief The number of bytes copied into scratch space.
+     */
+    auto copied() const -> size_t { return scratch_size_; }
+    auto threshold() const -> size_t { return threshold_; }
+  private:
+    /*
+     * Scratch segments are recorded by offset, since the scratch buffer may move as it grows.
+     */
+    struct segment
+    {
+      bool        external;
+      const char* data;
+      size_t      offset;
+      size_t      size;
+    };
+
+    size_t                    threshold_;
+    std::vector<char>         scratch_;
+    size_t                    scratch_size_ = 0;
+    size_t                    size_         = 0;
+    std::vector<segment>      segments_;
+    std::vector<struct iovec> iovecs_;
+  };
+} /* namespace tpl */
+
+#endif//gather_hpp_20201108_152031_PDT
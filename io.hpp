@@ -0,0 +1,114 @@
+#ifndef io_hpp_20201107_094406_PDT
+#define io_hpp_20201107_094406_PDT
+
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+#include <algorithm>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace tpl
+{
+  /*!
+   * \brief Writes whole buffers to a file descriptor, retrying short and interrupted writes; a writer for
+   *        `definition::batch_encoder::flush` and, via `writev`, for `gather_buffer::flush`.
+   *
+   *        Throws `std::system_error` if a write fails, e.g. `EAGAIN` on a non-blocking descriptor--in which case
+   *        some prefix of the buffer may already have been written.
+   */
+  class fd_writer
+  {
+  public:
+    explicit fd_writer(int fd)
+      : fd_(fd)
+      {}
+    auto operator()(const char* data, size_t size) const -> void
+      {
+        while(size != 0)
+        {
+          auto n = ::write(fd_, data, size);
+          if(n < 0)
+          {
+            if(errno == EINTR)
+            {
+              continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "write failed");
+          }
+          data += n;
+          size -= static_cast<size_t>(n);
+        }
+      }
+    auto operator()(const struct iovec* iov, size_t count) const -> void
+      {
+        while(count != 0)
+        {
+          auto n = ::writev(fd_, iov, static_cast<int>(std::min<size_t>(count, IOV_MAX)));
+          if(n < 0)
+          {
+            if(errno == EINTR)
+            {
+              continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "writev failed");
+          }
+          auto written = static_cast<size_t>(n);
+          while(count != 0 && written >= iov->iov_len)
+          {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+          }
+          if(written != 0)
+          {
+            // Finish the segment cut short, then carry on with whole segments.
+            (*this)(static_cast<const char*>(iov->iov_base) + written, iov->iov_len - written);
+            ++iov;
+            --count;
+          }
+        }
+      }
+    auto fd() const -> int { return fd_; }
+  private:
+    int fd_;
+  };
+
+  /*!
+   * \brief Reads from a file descriptor, retrying interrupted reads; the reader behind `pipeline`.
+   *
+   *        Throws `std::system_error` if a read fails.
+   */
+  class fd_reader
+  {
+  public:
+    explicit fd_reader(int fd)
+      : fd_(fd)
+      {}
+    /*!
+     * \brief Reads up to `size` bytes into `data`--whatever is available, once any is--and returns how many were
+     *        read, or 0 at the end of the input.
+     */
+    auto operator()(char* data, size_t size) const -> size_t
+      {
+        for(;;)
+        {
+          auto n = ::read(fd_, data, size);
+          if(n >= 0)
+          {
+            return static_cast<size_t>(n);
+          }
+          if(errno != EINTR)
+          {
+            throw std::system_error(errno, std::generic_category(), "read failed");
+          }
+        }
+      }
+    auto fd() const -> int { return fd_; }
+  private:
+    int fd_;
+  };
+} /* namespace tpl */
+
+#endif//io_hpp_20201107_094406_PDT
@@ -0,0 +1,745 @@
+#ifndef parallel_hpp_20201018_101544_PDT
+#define parallel_hpp_20201018_101544_PDT
+
+#include "protocol.hpp"
+#include "ring.hpp"
+#include <cpp/tuple.hpp>
+#include <cpp/type_traits.hpp>
+#include <cpp/cpp.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tpl
+{
+/*********************************************************************************************************************
+* Implementation of the work-stealing thread pool behind `parallel_decoder`.
+*
+* Each worker owns a deque of job numbers, which it pushes onto and takes from at the bottom while other workers steal
+* from the top--all without locks: an uncontended take is a few loads and stores, and a steal one compare-and-swap.  A
+* run either deals its jobs out at the start, in contiguous blocks, one block per worker, or is fed jobs one at a time
+* by the thread which started it.  In the former case a worker takes jobs from the front of its own block and steals
+* from the back of the others', so that, so long as every worker keeps up, each one decodes a contiguous run of the
+* input; in the latter, jobs are taken oldest first.  The thread which starts a run is worker 0, and does its share of
+* the jobs rather than sleeping.
+*
+* The pool's mutex is only taken to start and finish a run, and to put to sleep, or wake, a worker which has run out of
+* jobs.
+*********************************************************************************************************************/
+  namespace detail {
+
+      /*!
+       * \brief A lock-free deque of job numbers, after Chase and Lev's "Dynamic Circular Work-Stealing Deque": the
+       *        owning thread pushes and takes at the bottom, and any thread may steal from the top.
+       *
+       *        The owner grows the ring when it is full; the rings it replaces are kept until `reclaim`, since a
+       *        thief may still be reading one.  Positions only ever increase, and are mapped onto the ring modulo its
+       *        size.
+       */
+      class job_deque
+      {
+        struct ring
+        {
+          explicit ring(size_t capacity)
+            : mask(capacity - 1),
+              jobs(new std::atomic<size_t>[capacity])
+            {}
+          auto at(int64_t position) -> std::atomic<size_t>&
+            {
+              return jobs[static_cast<size_t>(position) & mask];
+            }
+
+          size_t                                 mask;
+          std::unique_ptr<std::atomic<size_t>[]> jobs;
+        };
+      public:
+        job_deque()
+          {
+            rings_.emplace_back(new ring(64));
+            ring_.store(rings_.back().get(), std::memory_order_relaxed);
+          }
+        job_deque(const job_deque&) = delete;
+        auto operator=(const job_deque&) -> job_deque& = delete;
+
+        /*!
+         * \brief Adds `job` at the bottom; owner only.
+         */
+        auto push(size_t job) -> void
+          {
+            auto b = bottom_.load(std::memory_order_relaxed);
+            auto t = top_.load(std::memory_order_acquire);
+            auto r = ring_.load(std::memory_order_relaxed);
+            if(b - t > static_cast<int64_t>(r->mask))
+            {
+              r = grow(r, t, b);
+            }
+            r->at(b).store(job, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_release);
+          }
+        /*!
+         * \brief Removes the job at the bottom, if any; owner only.
+         */
+        auto take(size_t& job) -> bool
+          {
+            auto b = bottom_.load(std::memory_order_relaxed) - 1;
+            auto r = ring_.load(std::memory_order_relaxed);
+            // Claim the bottom job before looking at the top, so that a thief which reads the old bottom loses the
+            // race for it below, and one which reads the new one leaves it alone.
+            bottom_.store(b, std::memory_order_seq_cst);
+            auto t = top_.load(std::memory_order_seq_cst);
+            if(t > b)
+            {
+              bottom_.store(b + 1, std::memory_order_relaxed);
+              return false;
+            }
+            job = r->at(b).load(std::memory_order_relaxed);
+            if(t != b)
+            {
+              return true;
+            }
+            // The last job, which a thief may be taking at the same time: whoever advances the top has it.
+            auto taken = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return taken;
+          }
+        /*!
+         * \brief Removes the job at the top, if any; any thread.
+         *
+         * \return false if the deque is empty, or another thread took the job first.
+         */
+        auto steal(size_t& job) -> bool
+          {
+            auto t = top_.load(std::memory_order_seq_cst);
+            auto b = bottom_.load(std::memory_order_seq_cst);
+            if(t >= b)
+            {
+              return false;
+            }
+            job = ring_.load(std::memory_order_acquire)->at(t).load(std::memory_order_relaxed);
+            return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+          }
+        /*!
+         * \brief Frees the rings replaced by growing; only while no other thread is using the deque.
+         */
+        auto reclaim() -> void
+          {
+            rings_.erase(rings_.begin(), rings_.end() - 1);
+          }
+      private:
+        auto grow(ring* r, int64_t t, int64_t b) -> ring*
+          {
+            std::unique_ptr<ring> bigger(new ring((r->mask + 1) * 2));
+            for(auto i = t; i < b; ++i)
+            {
+              bigger->at(i).store(r->at(i).load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            rings_.push_back(cpp::move(bigger));
+            ring_.store(rings_.back().get(), std::memory_order_release);
+            return rings_.back().get();
+          }
+
+        char                               thief_line_[cache_line_size];
+        std::atomic<int64_t>               top_    { 0 };
+        char                               owner_line_[cache_line_size];
+        std::atomic<int64_t>               bottom_ { 0 };
+        std::atomic<ring*>                 ring_   { nullptr };
+        std::vector<std::unique_ptr<ring>> rings_;
+      };
+
+      class work_stealing_pool
+      {
+      public:
+        using task_type = std::function<void(size_t worker, size_t job)>;
+
+        explicit work_stealing_pool(size_t thread_count)
+          {
+            if(thread_count == 0)
+            {
+              throw std::invalid_argument("thread pool requires at least one thread");
+            }
+            for(size_t i = 0; i < thread_count; ++i)
+            {
+              deques_.emplace_back(new job_deque);
+            }
+            for(size_t i = 1; i < thread_count; ++i)
+            {
+              threads_.emplace_back([this, i] { worker_main(i); });
+            }
+          }
+        ~work_stealing_pool()
+          {
+            {
+              std::lock_guard<std::mutex> lock(mutex_);
+              stopping_ = true;
+            }
+            start_.notify_all();
+            for(auto& t : threads_)
+            {
+              t.join();
+            }
+          }
+        work_stealing_pool(const work_stealing_pool&) = delete;
+        auto operator=(const work_stealing_pool&) -> work_stealing_pool& = delete;
+
+        auto size() const -> size_t { return deques_.size(); }
+
+        /*!
+         * \brief Runs `task` once for each job in `[0, job_count)` and waits for all of them to finish.  If any task
+         *        throws, the jobs not yet started are abandoned and the first exception is rethrown here.
+         */
+        auto run(size_t job_count, task_type task) -> void
+          {
+            start(job_count, cpp::move(task));
+            wait();
+          }
+        /*!
+         * \brief Deals out the jobs in `[0, job_count)` and wakes the other workers, without waiting.  Each `start`
+         *        must be followed by a `wait`, and the calling thread may `help` in between.
+         */
+        auto start(size_t job_count, task_type task) -> void
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            begin(lock, cpp::move(task), false);
+            auto workers = size();
+            for(size_t w = 0; w < workers; ++w)
+            {
+              // Pushed last to first, so that the owner takes its block from the front.
+              for(auto job = job_count * (w + 1) / workers; job > job_count * w / workers; --job)
+              {
+                deques_[w]->push(job - 1);
+              }
+            }
+            queued_.store(job_count);
+            remaining_.store(job_count);
+            closed_ = true;
+            ++generation_;
+            start_.notify_all();
+          }
+        /*!
+         * \brief Starts a run whose jobs are then given, one at a time, to `submit`, and wakes the other workers.
+         *        The run must be ended by `wait`.
+         */
+        auto start(task_type task) -> void
+          {
+            std::unique_lock<std::mutex> lock(mutex_);
+            begin(lock, cpp::move(task), true);
+            ++generation_;
+            start_.notify_all();
+          }
+        /*!
+         * \brief Adds a job to a run begun by `start(task)`; only from the thread which started it.
+         */
+        auto submit(size_t job) -> void
+          {
+            remaining_.fetch_add(1);
+            deques_[0]->push(job);
+            queued_.fetch_add(1);
+            if(sleepers_.load() != 0)
+            {
+              std::lock_guard<std::mutex> lock(mutex_);
+              work_.notify_one();
+            }
+          }
+        /*!
+         * \brief Runs one job on the calling thread (as worker 0), preferring one of its own.
+         *
+         * \return false if no job was left to take.
+         */
+        auto help() -> bool
+          {
+            size_t job;
+            if(!take(0, job))
+            {
+              return false;
+            }
+            execute(0, job);
+            return true;
+          }
+        /*!
+         * \brief Ends the run: helps until every job has been taken, then waits for the other workers to finish theirs.
+         */
+        auto wait() -> void
+          {
+            {
+              std::lock_guard<std::mutex> lock(mutex_);
+              closed_ = true;
+            }
+            work_.notify_all();
+            while(help())
+            {}
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return remaining_.load() == 0 && active_ == 0; });
+            task_ = nullptr;
+            if(error_)
+            {
+              auto error = error_;
+              error_ = nullptr;
+              std::rethrow_exception(error);
+            }
+          }
+        /*!
+         * \brief Abandons the jobs which have not been started, e.g. when the caller must unwind before `wait`.
+         */
+        auto cancel() -> void { cancelled_.store(true); }
+        auto cancelled() const -> bool { return cancelled_.load(); }
+      private:
+        /*
+         * Readies a run, once no worker is left in the previous one--so that no thread is reading the task or the
+         * deques.
+         */
+        auto begin(std::unique_lock<std::mutex>& lock, task_type task, bool fed) -> void
+          {
+            done_.wait(lock, [this] { return active_ == 0; });
+            for(auto& deque : deques_)
+            {
+              deque->reclaim();
+            }
+            task_      = cpp::move(task);
+            error_     = nullptr;
+            fed_       = fed;
+            closed_    = false;
+            cancelled_.store(false);
+          }
+        auto worker_main(size_t worker) -> void
+          {
+            size_t                       seen = 0;
+            std::unique_lock<std::mutex> lock(mutex_);
+            for(;;)
+            {
+              start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+              if(stopping_)
+              {
+                return;
+              }
+              seen = generation_;
+              ++active_;
+              // The task and the deques are left alone until this worker has left the run.
+              for(;;)
+              {
+                lock.unlock();
+                size_t job;
+                while(take(worker, job))
+                {
+                  execute(worker, job);
+                }
+                lock.lock();
+                ++sleepers_;
+                work_.wait(lock, [this] { return queued_.load() != 0 || closed_; });
+                --sleepers_;
+                if(queued_.load() == 0)
+                {
+                  break;
+                }
+              }
+              if(--active_ == 0)
+              {
+                done_.notify_all();
+              }
+            }
+          }
+        auto take(size_t worker, size_t& job) -> bool
+          {
+            auto workers = size();
+            auto& own    = *deques_[worker];
+            auto  taken  = fed_? own.steal(job) : own.take(job);
+            for(size_t i = 1; !taken && i < workers; ++i)
+            {
+              taken = deques_[(worker + i) % workers]->steal(job);
+            }
+            if(taken)
+            {
+              queued_.fetch_sub(1);
+            }
+            return taken;
+          }
+        auto execute(size_t worker, size_t job) -> void
+          {
+            if(!cancelled_.load(std::memory_order_relaxed))
+            {
+              try
+              {
+                task_(worker, job);
+              }
+              catch(...)
+              {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(!error_)
+                {
+                  error_ = std::current_exception();
+                }
+                cancelled_.store(true);
+              }
+            }
+            if(remaining_.fetch_sub(1) == 1)
+            {
+              std::lock_guard<std::mutex> lock(mutex_);
+              done_.notify_all();
+            }
+          }
+
+        std::vector<std::unique_ptr<job_deque>> deques_;
+        std::vector<std::thread>                threads_;
+        std::mutex                              mutex_;
+        std::condition_variable                 start_;
+        std::condition_variable                 work_;
+        std::condition_variable                 done_;
+        task_type                               task_;
+        std::exception_ptr                      error_;
+        size_t                                  generation_ = 0;
+        size_t                                  active_     = 0;
+        bool                                    fed_        = false;
+        bool                                    closed_     = false;
+        bool                                    stopping_   = false;
+        std::atomic<size_t>                     queued_     { 0 };
+        std::atomic<size_t>                     remaining_  { 0 };
+        std::atomic<size_t>                     sleepers_   { 0 };
+        std::atomic<bool>                       cancelled_  { false };
+      };
+
+      /*!
+       * \brief Finds the offsets at which to split the `size` bytes of length-prefixed messages at `data` into chunks
+       *        of at least `chunk_size` bytes, by hopping from frame header to frame header.  The result begins with
+       *        0 and ends with `size`, even if that is also 0: an empty buffer is one empty chunk.
+       */
+      inline auto frame_boundaries(const char* data, size_t size, size_t chunk_size) -> std::vector<size_t>
+        {
+          std::vector<size_t> boundaries { 0 };
+          auto begin = data;
+          auto end   = data + size;
+          auto last  = data;
+          while(begin < end)
+          {
+            if(framer<framing::length_prefixed>::skip(begin, end) != 0)
+            {
+              throw std::length_error("frame length greater than remaining stream length");
+            }
+            if(static_cast<size_t>(begin - last) >= chunk_size)
+            {
+              boundaries.push_back(static_cast<size_t>(begin - data));
+              last = begin;
+            }
+          }
+          if(boundaries.size() == 1 || boundaries.back() != size)
+          {
+            boundaries.push_back(size);
+          }
+          return boundaries;
+        }
+
+      /*!
+       * \brief The messages decoded from one chunk, held for an ordered merge: one vector per message type, and the
+       *        sequence of type indices in which they occurred.
+       */
+      template<typename MT>
+      struct decoded_chunk;
+
+      template<typename...MessageTs>
+      struct decoded_chunk<cpp::tuple<MessageTs...>>
+      {
+        using message_tuple = cpp::tuple<MessageTs...>;
+
+        cpp::tuple<std::vector<MessageTs>...> messages;
+        std::vector<unsigned char>            order;
+
+        template<typename MessageT>
+        auto operator()(MessageT&& m) -> void
+          {
+            using message_type = cpp::remove_const_t<cpp::remove_reference_t<MessageT>>;
+            constexpr size_t index = message_index_from<static_cast<size_t>(message_type::message_type_id()), message_tuple>::value;
+            cpp::get<index>(messages).push_back(cpp::forward<MessageT>(m));
+            order.push_back(static_cast<unsigned char>(index));
+          }
+
+        /*!
+         * \brief Passes the messages to `handler` in their original order, then destroys them--keeping the vectors'
+         *        capacity, for the next chunk decoded into this one.
+         */
+        template<typename HandlerT>
+        auto replay(HandlerT& handler) -> void
+          {
+            size_t cursors[sizeof...(MessageTs)] = {};
+            auto table = replay_table<HandlerT>(make_index_sequence<sizeof...(MessageTs)>{});
+            for(auto index : order)
+            {
+              table[index](*this, cursors, handler);
+            }
+            clear(make_index_sequence<sizeof...(MessageTs)>{});
+          }
+      private:
+        template<size_t...Is>
+        auto clear(index_sequence<Is...>) -> void
+          {
+            int expansion[] = { 0, (cpp::get<Is>(messages).clear(), 0)... };
+            (void)expansion;
+            order.clear();
+          }
+
+        template<typename HandlerT>
+          using replay_type = auto (*)(decoded_chunk&, size_t*, HandlerT&) -> void;
+
+        template<size_t I, typename HandlerT>
+        static auto replay_one(decoded_chunk& self, size_t* cursors, HandlerT& handler) -> void
+          {
+            handler(cpp::move(cpp::get<I>(self.messages)[cursors[I]++]));
+          }
+        template<typename HandlerT, size_t...Is>
+        static auto replay_table(index_sequence<Is...>) -> const replay_type<HandlerT>*
+          {
+            static constexpr replay_type<HandlerT> table[] = { &replay_one<Is, HandlerT>... };
+            return table;
+          }
+      };
+  } /* namespace detail */
+
+  /*!
+   * \brief Decodes large buffers of length-prefixed messages (see `framed_definition`) on several threads.
+   *
+   *        The buffer is split into chunks at frame boundaries--found either by a scan over the frame headers, or
+   *        taken from a side index, such as an archive's--and the chunks are decoded on a work-stealing pool.  The
+   *        messages are delivered in one of two ways:
+   *
+   *        - `decode` gives each thread its own handler, each of which sees the messages of whichever chunks its
+   *          thread decodes, in order within a chunk but in no particular order across chunks.  A handler is either a
+   *          `visitor` or a callable accepted by `dispatch`.
+   *        - `decode_ordered` delivers every message to a single callable, on the calling thread, in input order.
+   *          Chunks are decoded ahead in parallel and held until the merge reaches them--but no more than
+   *          `look_ahead_per_thread` chunks per thread ahead of it, so that a slow handler does not leave the whole
+   *          input held in memory as decoded messages.
+   *
+   *        The pool's threads persist for the lifetime of the decoder, so that it can be reused across buffers.
+   */
+  template<typename DefinitionT>
+  class parallel_decoder
+  {
+    static_assert(cpp::is_same<typename DefinitionT::framing_type, framing::length_prefixed>::value, "Parallel decoding requires a framed_definition, whose message boundaries can be found without decoding.");
+
+    using message_tuple = typename DefinitionT::message_tuple_type;
+    using visitor_type  = typename DefinitionT::visitor;
+    using chunk_type    = detail::decoded_chunk<message_tuple>;
+
+    /*
+     * A chunk of the window of `decode_ordered`, which holds chunk `k` in slot `k % window`.
+     */
+    struct window_slot
+    {
+      chunk_type        chunk;
+      std::atomic<bool> ready { false };
+    };
+
+    /*
+     * Wakes the merge when a chunk is ready or the run fails--taking the lock only if the merge is asleep.
+     */
+    struct merge_signal
+    {
+      std::mutex              mutex;
+      std::condition_variable wake;
+      std::atomic<bool>       sleeping { false };
+
+      auto notify() -> void
+        {
+          if(sleeping.load())
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            wake.notify_one();
+          }
+        }
+    };
+
+    template<typename HandlerT>
+    static auto decode_chunk(const char* data, size_t size, HandlerT& handler, std::true_type) -> void
+      {
+        handler.accept(data, size);
+      }
+    template<typename HandlerT>
+    static auto decode_chunk(const char* data, size_t size, HandlerT& handler, std::false_type) -> void
+      {
+        DefinitionT::dispatch(data, size, handler);
+      }
+  public:
+    /*!
+     * \brief How many chunks, per thread, `decode_ordered` may decode ahead of the merge: enough that the threads
+     *        keep busy while the merge replays a chunk.
+     */
+    static constexpr size_t look_ahead_per_thread = 4;
+
+    /*!
+     * \brief Creates a decoder which runs on `thread_count` threads, including the calling thread.
+     */
+    explicit parallel_decoder(size_t thread_count = std::max(std::thread::hardware_concurrency(), 1u))
+      : pool_(thread_count)
+      {}
+
+    auto thread_count() const -> size_t { return pool_.size(); }
+
+    /*!
+     * \brief The chunk size used when none is given: enough chunks that stealing can even out the threads' loads,
+     *        but no smaller than 64KiB.
+     */
+    auto default_chunk_size(size_t size) const -> size_t
+      {
+        return std::max(size / (thread_count() * 16), size_t { 64 * 1024 });
+      }
+    /*!
+     * \brief Scans the frame headers of the `size` bytes at `data` for chunk boundaries; see `decode`.
+     */
+    auto boundaries(const char* data, size_t size) const -> std::vector<size_t>
+      {
+        return detail::frame_boundaries(data, size, default_chunk_size(size));
+      }
+
+    /*!
+     * \brief Decodes the `size` bytes at `data`, passing the messages decoded by thread `i` to `handlers[i]`.
+     *        `handlers` must hold at least `thread_count()` handlers.
+     */
+    template<typename HandlerT>
+    auto decode(const char* data, size_t size, std::vector<HandlerT>& handlers) -> void
+      {
+        decode(data, size, boundaries(data, size), handlers);
+      }
+    template<typename HandlerT>
+    auto decode(const cpp::string& s, std::vector<HandlerT>& handlers) -> void
+      {
+        decode(s.data(), s.size(), handlers);
+      }
+    /*!
+     * \brief As above, but split at the given `boundaries`: ascending offsets of frames in the input, beginning with
+     *        0 and ending with `size`.
+     */
+    template<typename HandlerT>
+    auto decode(const char* data, size_t size, const std::vector<size_t>& boundaries, std::vector<HandlerT>& handlers) -> void
+      {
+        if(handlers.size() < thread_count())
+        {
+          throw std::invalid_argument("parallel decode requires a handler per thread");
+        }
+        check_boundaries(size, boundaries);
+        pool_.run(boundaries.size() - 1, [&](size_t worker, size_t job)
+          {
+            decode_chunk(data + boundaries[job], boundaries[job + 1] - boundaries[job], handlers[worker], std::is_base_of<visitor_type, HandlerT> {});
+          });
+      }
+
+    /*!
+     * \brief Decodes the `size` bytes at `data` in parallel, and passes every message to `handler`, which must be
+     *        callable with each message type, on the calling thread and in input order.
+     */
+    template<typename HandlerT>
+    auto decode_ordered(const char* data, size_t size, HandlerT&& handler) -> void
+      {
+        decode_ordered(data, size, boundaries(data, size), handler);
+      }
+    template<typename HandlerT>
+    auto decode_ordered(const cpp::string& s, HandlerT&& handler) -> void
+      {
+        decode_ordered(s.data(), s.size(), handler);
+      }
+    template<typename HandlerT>
+    auto decode_ordered(const char* data, size_t size, const std::vector<size_t>& boundaries, HandlerT&& handler) -> void
+      {
+        check_boundaries(size, boundaries);
+        auto chunk_count = boundaries.size() - 1;
+        auto window      = std::min(chunk_count, thread_count() * look_ahead_per_thread);
+        std::unique_ptr<window_slot[]> slots(new window_slot[window]);
+        merge_signal                   signal;
+        pool_.start([&](size_t, size_t job)
+          {
+            auto& slot = slots[job % window];
+            try
+            {
+              DefinitionT::dispatch(data + boundaries[job], boundaries[job + 1] - boundaries[job], slot.chunk);
+            }
+            catch(...)
+            {
+              pool_.cancel();
+              signal.notify();
+              throw;
+            }
+            slot.ready.store(true);
+            signal.notify();
+          });
+        try
+        {
+          for(size_t job = 0; job < window; ++job)
+          {
+            pool_.submit(job);
+          }
+          for(size_t job = 0; job < chunk_count; ++job)
+          {
+            auto& slot = slots[job % window];
+            if(!wait_ready(slot, signal))
+            {
+              break;
+            }
+            slot.chunk.replay(handler);
+            slot.ready.store(false, std::memory_order_relaxed);
+            // The slot is free: decode the chunk which will next occupy it.
+            if(job + window < chunk_count)
+            {
+              pool_.submit(job + window);
+            }
+          }
+        }
+        catch(...)
+        {
+          pool_.cancel();
+          try
+          {
+            pool_.wait();
+          }
+          catch(...)
+          {}
+          throw;
+        }
+        pool_.wait();
+      }
+  private:
+    static auto check_boundaries(size_t size, const std::vector<size_t>& boundaries) -> void
+      {
+        if(boundaries.size() < 2 || boundaries.front() != 0 || boundaries.back() != size || !std::is_sorted(boundaries.begin(), boundaries.end()))
+        {
+          throw std::invalid_argument("chunk boundaries must ascend from 0 to the buffer size");
+        }
+      }
+    /*
+     * Rather than sleep while the next chunk is decoded elsewhere, the merging thread decodes chunks itself--the
+     * oldest first, most likely the very one it is waiting for.
+     *
+     * Returns false if the run has failed, and the chunk will never be ready.
+     */
+    auto wait_ready(window_slot& slot, merge_signal& signal) -> bool
+      {
+        for(;;)
+        {
+          if(slot.ready.load())
+          {
+            return true;
+          }
+          if(pool_.cancelled())
+          {
+            return false;
+          }
+          if(!pool_.help())
+          {
+            std::unique_lock<std::mutex> lock(signal.mutex);
+            signal.sleeping.store(true);
+            signal.wake.wait(lock, [&] { return slot.ready.load() || pool_.cancelled(); });
+            signal.sleeping.store(false);
+          }
+        }
+      }
+
+    detail::work_stealing_pool pool_;
+  };
+} /* namespace tpl */
+
+#endif//parallel_hpp_20201018_101544_PDT
@@ -0,0 +1,372 @@
+#ifndef pipeline_hpp_20201114_103318_PDT
+#define pipeline_hpp_20201114_103318_PDT
+
+#include "protocol.hpp"
+#include "parallel.hpp"
+#include "ring.hpp"
+#include "io.hpp"
+#include <cpp/type_traits.hpp>
+#include <cpp/cpp.hpp>
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tpl
+{
+  namespace detail {
+    /*!
+     * \brief Whether a field type decodes to a value which refers into the input--a `string_ref`, or a sequence or
+     *        tuple holding one--rather than owning a copy.
+     */
+    template<typename T>
+    struct refers_to_input : std::false_type {};
+
+    template<>
+    struct refers_to_input<string_ref> : std::true_type {};
+
+    template<typename T, typename AllocatorT>
+    struct refers_to_input<std::vector<T, AllocatorT>> : refers_to_input<T> {};
+
+    template<typename T, size_t N>
+    struct refers_to_input<std::array<T, N>> : refers_to_input<T> {};
+
+    template<>
+    struct refers_to_input<cpp::tuple<>> : std::false_type {};
+
+    template<typename T, typename...Ts>
+    struct refers_to_input<cpp::tuple<T, Ts...>> : std::integral_constant<bool, refers_to_input<T>::value || refers_to_input<cpp::tuple<Ts...>>::value> {};
+
+    /*!
+     * \brief The field tuples of a tuple of message types, as a tuple.
+     */
+    template<typename MT>
+    struct fields_of;
+
+    template<typename...MessageTs>
+    struct fields_of<cpp::tuple<MessageTs...>>
+    {
+      using type = cpp::tuple<typename MessageTs::field_tuple_type...>;
+    };
+  } /* namespace detail */
+
+/*********************************************************************************************************************
+* Implementation of `pipeline` class.
+*
+* Three stages, each on its own thread and connected by `spsc_ring`s, so that reading, decoding and handling overlap:
+*
+*   - the reader fills buffers from the file descriptor and passes each on as a chunk of raw bytes, then waits for an
+*     empty buffer to come back--with two buffers, it reads into one while the other is decoded;
+*   - the decoder (the thread which calls `run`) decodes each chunk with `definition::try_dispatch`, keeping the tail
+*     of a message cut off by the end of a chunk until the next chunk completes it, then returns the buffer;
+*   - optionally, workers: the decoder routes each message, by type, to a worker's batch, and passes the batches on
+*     at the end of each chunk, so that the rings carry one element per chunk per worker rather than per message.
+*
+* A message handled on the decoder's thread may refer into the buffer (a `string_ref` field) until its handler
+* returns.  A batch, though, may still be waiting for its worker after its buffer has been refilled, or after the tail
+* it was completed in has been overwritten; so a definition whose fields refer into the input cannot use workers.
+*
+* A failure in any stage stops the others and is rethrown by `run`.  The reader can only stop between reads, so a
+* failure elsewhere is reported once its read in progress returns.
+*********************************************************************************************************************/
+  /*!
+   * \brief Reads, decodes and handles a stream of messages from a file descriptor (a pipe, socket or file) on
+   *        separate threads.
+   */
+  template<typename DefinitionT>
+  class pipeline
+  {
+    using message_tuple = typename DefinitionT::message_tuple_type;
+    using batch_type    = detail::decoded_chunk<message_tuple>;
+
+    struct chunk
+    {
+      char*  data;
+      size_t size;
+    };
+
+    /*
+     * Sorts decoded messages into one batch per worker.
+     */
+    struct router
+    {
+      std::vector<batch_type>&   batches;
+      const std::vector<size_t>& worker_of;
+
+      template<typename MessageT>
+      auto operator()(MessageT&& m) -> void
+        {
+          using message_type = cpp::remove_const_t<cpp::remove_reference_t<MessageT>>;
+          constexpr size_t index = detail::message_index_from<static_cast<size_t>(message_type::message_type_id()), message_tuple>::value;
+          batches[worker_of[index]](cpp::forward<MessageT>(m));
+        }
+    };
+  public:
+    /*!
+     * \brief Creates a pipeline over `fd`, reading `chunk_size` bytes at a time into `buffer_count` buffers, whose
+     *        rings between the decoder and each worker hold up to `ring_capacity` batches.
+     */
+    explicit pipeline(int fd, size_t chunk_size = 64 * 1024, size_t buffer_count = 2, size_t ring_capacity = 64)
+      : reader_(fd),
+        chunk_size_(chunk_size),
+        ring_capacity_(ring_capacity)
+      {
+        if(chunk_size == 0 || buffer_count == 0)
+        {
+          throw std::invalid_argument("pipeline requires at least one non-empty buffer");
+        }
+        for(size_t i = 0; i < buffer_count; ++i)
+        {
+          buffers_.emplace_back(new char[chunk_size]);
+        }
+      }
+
+    /*!
+     * \brief Decodes every message until the end of the input and passes it to `handler`--any handler accepted by
+     *        `definition::dispatch`--on the calling thread.  Reading proceeds on a thread of its own.
+     */
+    template<typename HandlerT>
+    auto run(HandlerT&& handler) -> void
+      {
+        read_chunks([&](const char* data, size_t size)
+          {
+            decode(data, size, handler);
+            return true;
+          });
+      }
+    /*!
+     * \brief Decodes every message until the end of the input, on the calling thread, and passes it to one of
+     *        `handlers`, each of which runs on a worker thread of its own: a message goes to
+     *        `handlers[route(id)]`, where `id` is its message type ID.  Each handler must be callable with the
+     *        message types routed to it, and sees them in input order.  No field may refer into the input.
+     */
+    template<typename HandlerT, typename RouteT>
+    auto run(std::vector<HandlerT>& handlers, RouteT&& route) -> void
+      {
+        static_assert(!detail::refers_to_input<typename detail::fields_of<message_tuple>::type>::value,
+                      "Messages with string_ref fields may outlive their buffer in a worker's batch; use owned strings, or run without workers.");
+        auto worker_of = route_table(route, detail::make_index_sequence<cpp::tuple_size<message_tuple>::value>{});
+        for(auto worker : worker_of)
+        {
+          if(worker >= handlers.size())
+          {
+            throw std::invalid_argument("pipeline route names no handler");
+          }
+        }
+        std::vector<std::unique_ptr<spsc_ring<batch_type>>> rings;
+        std::vector<std::exception_ptr>                     errors(handlers.size());
+        std::vector<std::thread>                            workers;
+        for(size_t i = 0; i < handlers.size(); ++i)
+        {
+          rings.emplace_back(new spsc_ring<batch_type>(ring_capacity_));
+        }
+        auto stop_workers = [&]
+          {
+            for(auto& ring : rings)
+            {
+              ring->close();
+            }
+            for(auto& worker : workers)
+            {
+              worker.join();
+            }
+          };
+        try
+        {
+          for(size_t i = 0; i < handlers.size(); ++i)
+          {
+            workers.emplace_back([&, i]
+              {
+                work(*rings[i], handlers[i], errors[i]);
+              });
+          }
+          std::vector<batch_type> batches(handlers.size());
+          router                  sort { batches, worker_of };
+          read_chunks([&](const char* data, size_t size)
+            {
+              decode(data, size, sort);
+              for(size_t i = 0; i < batches.size(); ++i)
+              {
+                if(!batches[i].order.empty() && !rings[i]->push(cpp::move(batches[i])))
+                {
+                  // The worker has failed; its error is rethrown below.
+                  return false;
+                }
+                batches[i] = batch_type();
+              }
+              return true;
+            });
+        }
+        catch(...)
+        {
+          stop_workers();
+          throw;
+        }
+        stop_workers();
+        for(auto& error : errors)
+        {
+          if(error)
+          {
+            std::rethrow_exception(error);
+          }
+        }
+      }
+
+    auto chunk_size() const -> size_t { return chunk_size_; }
+    auto buffer_count() const -> size_t { return buffers_.size(); }
+  private:
+    /*
+     * Runs the reader on a thread of its own, and passes each chunk it reads to `consume` until the end of the input,
+     * or until `consume` returns false.
+     */
+    template<typename ConsumeT>
+    auto read_chunks(ConsumeT&& consume) -> void
+      {
+        spsc_ring<char*>   empty(buffers_.size());
+        spsc_ring<chunk>   filled(buffers_.size());
+        std::exception_ptr error;
+        for(auto& buffer : buffers_)
+        {
+          empty.push(buffer.get());
+        }
+        tail_.clear();
+        std::thread reader([&]
+          {
+            read(empty, filled, error);
+          });
+        auto stop_reader = [&]
+          {
+            empty.close();
+            filled.close();
+            reader.join();
+          };
+        auto more = true;
+        try
+        {
+          chunk c { nullptr, 0 };
+          while(more && filled.pop(c))
+          {
+            more = consume(static_cast<const char*>(c.data), c.size);
+            empty.push(c.data);
+          }
+        }
+        catch(...)
+        {
+          stop_reader();
+          throw;
+        }
+        stop_reader();
+        if(error)
+        {
+          std::rethrow_exception(error);
+        }
+        if(more && !tail_.empty())
+        {
+          throw std::length_error("input ends partway through a message");
+        }
+      }
+    auto read(spsc_ring<char*>& empty, spsc_ring<chunk>& filled, std::exception_ptr& error) -> void
+      {
+        try
+        {
+          char* buffer = nullptr;
+          while(empty.pop(buffer))
+          {
+            auto size = reader_(buffer, chunk_size_);
+            if(size == 0 || !filled.push(chunk { buffer, size }))
+            {
+              break;
+            }
+          }
+        }
+        catch(...)
+        {
+          error = std::current_exception();
+        }
+        filled.close();
+      }
+    template<typename HandlerT>
+    static auto work(spsc_ring<batch_type>& ring, HandlerT& handler, std::exception_ptr& error) -> void
+      {
+        try
+        {
+          batch_type batch;
+          while(ring.pop(batch))
+          {
+            batch.replay(handler);
+          }
+        }
+        catch(...)
+        {
+          error = std::current_exception();
+          // Makes the decoder's next push to this worker fail, which stops the pipeline.
+          ring.close();
+        }
+      }
+    /*
+     * Decodes a chunk, beginning with the message left incomplete by the previous one, if any--completed a few bytes
+     * at a time, since `bytes_needed` is only a lower bound, so that the tail never holds more than that message.
+     */
+    template<typename HandlerT>
+    auto decode(const char* data, size_t size, HandlerT& handler) -> void
+      {
+        while(!tail_.empty())
+        {
+          auto result = DefinitionT::try_dispatch(tail_.data(), tail_.size(), handler);
+          if(result)
+          {
+            tail_.clear();
+            break;
+          }
+          if(result.status != decode_status::truncated)
+          {
+            fail(tail_.data(), tail_.size(), result, handler);
+          }
+          if(size == 0)
+          {
+            return;
+          }
+          auto n = std::min(result.bytes_needed, size);
+          tail_.append(data, n);
+          data += n;
+          size -= n;
+        }
+        auto result = DefinitionT::try_dispatch(data, size, handler);
+        if(!result)
+        {
+          if(result.status != decode_status::truncated)
+          {
+            fail(data, size, result, handler);
+          }
+          tail_.assign(data + result.offset, size - result.offset);
+        }
+      }
+    /*
+     * Decodes the offending message with the throwing decoder, to raise the same error as `dispatch` would--without
+     * stats, since the failure has been recorded already.
+     */
+    template<typename HandlerT>
+    static auto fail(const char* data, size_t size, const decode_result& result, HandlerT& handler) -> void
+      {
+        DefinitionT::template with_stats<null_stats>::dispatch(data + result.offset, size - result.offset, handler);
+        throw std::runtime_error("malformed message");
+      }
+    template<typename RouteT, size_t...Is>
+    static auto route_table(RouteT& route, detail::index_sequence<Is...>) -> std::vector<size_t>
+      {
+        return std::vector<size_t> { static_cast<size_t>(route(cpp::tuple_element_t<Is, message_tuple>::message_type_id()))... };
+      }
+
+    fd_reader                             reader_;
+    size_t                                chunk_size_;
+    size_t                                ring_capacity_;
+    std::vector<std::unique_ptr<char[]>>  buffers_;
+    cpp::string                           tail_;
+  };
+} /* namespace tpl */
+
+#endif//pipeline_hpp_20201114_103318_PDT
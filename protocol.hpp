@@ -2,18 +2,138 @@
 #define protocol_hpp_20200903_133809_PDT
 
 #include "field.hpp"
+#include "buffer.hpp"
+#include "varint.hpp"
 #include <cpp/tuple.hpp>
 #include <cpp/type_traits.hpp>
 #include <cpp/cpp.hpp>
 #include <string>
 #include <vector>
+#include <array>
 #include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <type_traits>
+#include <memory>
+
+/*
+ * `TEMPLAR_COLD` marks a function which runs rarely, so that the compiler keeps it out of line, and its cost out of its
+ * callers'.  `TEMPLAR_INLINE` marks one which must be inlined even where the compiler would not--on the path taken
+ * when an exception unwinds the stack, say--because the call would keep its object's members out of registers.
+ */
+#if defined(__GNUC__)
+#define TEMPLAR_COLD   __attribute__((noinline, cold))
+#define TEMPLAR_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define TEMPLAR_COLD   __declspec(noinline)
+#define TEMPLAR_INLINE __forceinline
+#else
+#define TEMPLAR_COLD
+#define TEMPLAR_INLINE inline
+#endif
 
 namespace tpl
 {
 
 /*********************************************************************************************************************
-* Implementation of `MessageSerializer` class, which packs the data from a `Message` into a string.
+* Metafunction mapping the field types named in a `Message` definition onto the types stored in its field tuple.  These
+* are the same, except that C-arrays--which a tuple cannot be constructed from--are stored as `std::array`, and that
+* strings and `std::vector`s are rebound to the message's allocator (see `protocol::basic_message`), at any depth.  With
+* the default allocator, the rebound types are the named ones.
+*********************************************************************************************************************/
+  namespace detail {
+
+    template<typename FT, typename AllocatorT = std::allocator<char>>
+    struct message_field_storage
+    {
+      using type = FT;
+    };
+
+    template<typename T, size_t N, typename AllocatorT>
+    struct message_field_storage<T[N], AllocatorT>
+    {
+      using type = std::array<typename message_field_storage<T, AllocatorT>::type, N>;
+    };
+
+    template<typename TraitsT, typename StringAllocatorT, typename AllocatorT>
+    struct message_field_storage<std::basic_string<char, TraitsT, StringAllocatorT>, AllocatorT>
+    {
+      using type = std::basic_string<char, TraitsT, typename std::allocator_traits<AllocatorT>::template rebind_alloc<char>>;
+    };
+
+    template<typename T, typename SequenceAllocatorT, typename AllocatorT>
+    struct message_field_storage<std::vector<T, SequenceAllocatorT>, AllocatorT>
+    {
+      using element_type = typename message_field_storage<T, AllocatorT>::type;
+      using type         = std::vector<element_type, typename std::allocator_traits<AllocatorT>::template rebind_alloc<element_type>>;
+    };
+
+    template<typename FT, typename AllocatorT = std::allocator<char>>
+      using message_field_storage_t = typename message_field_storage<FT, AllocatorT>::type;
+
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of `FixedMessageCodec` class, the whole-message path for messages whose fields are all fixed-width.
+*
+* Every field of such a message lies at a compile-time offset (`OffsetN`, accumulated along the recursion), so the
+* message is encoded and decoded as one block: one bounds check for the whole message, after which each field is read
+* or written at its offset with a range of exactly its own size--whose bounds check the compiler folds away--instead of
+* each field checking and advancing a shared cursor.  The encoding is the same as the fieldwise path's.
+*********************************************************************************************************************/
+  namespace detail {
+
+    template<size_t I, typename T, size_t OffsetN = 0, typename EnableT = void>
+    class FixedMessageCodec;
+
+    template<size_t I, typename T, size_t OffsetN>
+    class FixedMessageCodec<I, T, OffsetN, cpp::enable_if_t<I == cpp::tuple_size<T>::value>>
+    {
+    public:
+      static constexpr size_t size = OffsetN;
+
+      static auto serialize(char* out, const T& t) -> void
+        {
+        }
+      template<typename...ArgTs>
+      static auto deserialize(const char* p, ArgTs&&...args) -> T
+        {
+          return T { cpp::forward<ArgTs>(args)... };
+        }
+    };
+
+    template<size_t I, typename T, size_t OffsetN>
+    class FixedMessageCodec<I, T, OffsetN, cpp::enable_if_t<I != cpp::tuple_size<T>::value>>
+    {
+      using field_type = Field<cpp::tuple_element_t<I, T>>;
+      using next_type  = FixedMessageCodec<I + 1, T, OffsetN + field_type::fixed_size>;
+      static_assert(field_type::is_fixed_width, "FixedMessageCodec requires fixed-width fields");
+    public:
+      static constexpr size_t size = next_type::size;
+
+      /*!
+       * \brief Writes the fields from `I` onwards at `out`, which must have room for `size - OffsetN` more bytes.
+       */
+      static auto serialize(char* out, const T& t) -> void
+        {
+          auto p = out + OffsetN;
+          field_type::serialize(p, cpp::get<I>(t));
+          next_type::serialize(out, t);
+        }
+      /*!
+       * \brief Reads the fields from `I` onwards from `p`, which must hold at least `size` bytes.
+       */
+      template<typename...ArgTs>
+      static auto deserialize(const char* p, ArgTs&&...args) -> T
+        {
+          auto q     = p + OffsetN;
+          auto field = field_type::deserialize(q, q + field_type::fixed_size);
+          return next_type::deserialize(p, cpp::forward<ArgTs>(args)..., cpp::move(field));
+        }
+    };
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of `MessageSerializer` class, which packs the data from a `Message` into a byte buffer.
 *********************************************************************************************************************/
   namespace detail {
 
@@ -24,21 +144,102 @@ namespace tpl
     class MessageSerializer<IDX, TupleT, cpp::enable_if_t<cpp::tuple_size<TupleT>::value == IDX>>
     {
     public:
-      static auto serialize(cpp::string& s, const TupleT& t) -> void
+      static constexpr bool   is_fixed_width = true;
+      static constexpr size_t fixed_size     = 0;
+
+      static auto serialized_size(const TupleT& t) -> size_t
+        {
+          return 0;
+        }
+      static auto serialize(char*& out, const TupleT& t) -> void
         {
                 
+        }
+      template<typename GatherT>
+      static auto serialize_gather(GatherT& out, const TupleT& t) -> void
+        {
         }
     };
 
     template<size_t IDX, typename TupleT>
     class MessageSerializer<IDX, TupleT, cpp::enable_if_t<cpp::tuple_size<TupleT>::value != IDX>>
+    {
+      using type       = cpp::tuple_element_t<IDX, TupleT>;
+      using next_type  = MessageSerializer<IDX + 1, TupleT>;
+    public:
+      static constexpr bool   is_fixed_width = Field<type>::is_fixed_width && next_type::is_fixed_width;
+      static constexpr size_t fixed_size     = is_fixed_width? Field<type>::fixed_size + next_type::fixed_size : 0;
+
+      static auto serialized_size(const TupleT& t) -> size_t
+        {
+          return Field<type>::serialized_size(cpp::get<IDX>(t)) + next_type::serialized_size(t);
+        }
+      static auto serialize(char*& out, const TupleT& t) -> void
+        {
+          serialize(out, t, std::integral_constant<bool, IDX == 0 && is_fixed_width> {});
+        }
+      template<typename GatherT>
+      static auto serialize_gather(GatherT& out, const TupleT& t) -> void
+        {
+          detail::serialize_gather<Field<type>>(out, cpp::get<IDX>(t));
+          next_type::serialize_gather(out, t);
+        }
+    private:
+      static auto serialize(char*& out, const TupleT& t, std::true_type) -> void
+        {
+          FixedMessageCodec<0, TupleT>::serialize(out, t);
+          out += fixed_size;
+        }
+      static auto serialize(char*& out, const TupleT& t, std::false_type) -> void
+        {
+          Field<type>::serialize(out, cpp::get<IDX>(t));
+          next_type::serialize(out, t);
+        }
+    };
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of `MessageSkipper` class, which finds the end of an encoded `Message` without decoding it.
+*********************************************************************************************************************/
+  namespace detail {
+
+    template<size_t IDX, typename TupleT, typename EnableT = void>
+    class MessageSkipper {};
+
+    template<size_t IDX, typename TupleT>
+    class MessageSkipper<IDX, TupleT, cpp::enable_if_t<cpp::tuple_size<TupleT>::value == IDX>>
+    {
+    public:
+      static auto skip(const char*& begin, const char* end) -> size_t
+        {
+          return 0;
+        }
+    };
+
+    template<size_t IDX, typename TupleT>
+    class MessageSkipper<IDX, TupleT, cpp::enable_if_t<cpp::tuple_size<TupleT>::value != IDX>>
     {
     public:
-      static auto serialize(cpp::string& s, const TupleT& t) -> void
+      /*!
+       * \brief Same contract as `Field::skip`, for the fields from `IDX` onwards.
+       */
+      static auto skip(const char*& begin, const char* end) -> size_t
+        {
+          return skip(begin, end, std::integral_constant<bool, IDX == 0 && MessageSerializer<0, TupleT>::is_fixed_width> {});
+        }
+    private:
+      static auto skip(const char*& begin, const char* end, std::true_type) -> size_t
+        {
+          return skip_fixed<MessageSerializer<0, TupleT>::fixed_size>(begin, end);
+        }
+      static auto skip(const char*& begin, const char* end, std::false_type) -> size_t
         {
           using type = cpp::tuple_element_t<IDX, TupleT>;
-          Field<type>::serialize(s, cpp::get<IDX>(t));
-          MessageSerializer<IDX + 1, TupleT>::serialize(s, t);
+          auto missing = Field<type>::skip(begin, end);
+          if(missing != 0)
+          {
+            return missing;
+          }
+          return MessageSkipper<IDX + 1, TupleT>::skip(begin, end);
         }
     };
   } // namespace detail
@@ -93,7 +294,11 @@ namespace tpl
 
   }// namespace detail
 /*********************************************************************************************************************
-* Implementation of `MessageDeserializer` class, which unpacks the data from a string into a `Message` object.
+* Implementation of `MessageDeserializer` class, which unpacks the data from a byte range into a `Message` object.
+*
+* `deserialize` builds a new field tuple, moving each decoded field along to the next level.  `deserialize_into`
+* decodes into an existing tuple instead, so that string and sequence fields reuse their capacity (see
+* `detail::deserialize_into`); if it throws, the tuple is left partly updated.
 *********************************************************************************************************************/
   namespace detail {
     
@@ -104,31 +309,38 @@ namespace tpl
       class MessageDeserializer<I, T, cpp::enable_if_t<I == cpp::tuple_size<T>::value>>
       {
           using tuple_type = T;
-          using string_iter = cpp::string::const_iterator;
       public:
-          static auto deserialize(string_iter& begin, const string_iter& end) -> tuple_type
+          static auto deserialize(const char*& begin, const char* end) -> tuple_type
           {
             return tuple_type {};
           }
         template<typename...ArgTs>
-          static auto deserialize(string_iter& begin, const string_iter& end, ArgTs&&...args) -> tuple_type
+          static auto deserialize(const char*& begin, const char* end, ArgTs&&...args) -> tuple_type
           {
             return tuple_type { cpp::forward<ArgTs>(args)... };
           }
+          static auto deserialize_into(const char*& begin, const char* end, tuple_type& t) -> void
+          {
+          }
       };
 
       template<size_t I, typename T>
       class MessageDeserializer<I, T, cpp::enable_if_t<I != 0 && I != cpp::tuple_size<T>::value>>
       {
         using tuple_type = T;
-        using string_iter = cpp::string::const_iterator;
       public:
         template<typename...ArgTs>
-          static auto deserialize(string_iter& begin, const string_iter& end, ArgTs&&...args) -> tuple_type
+          static auto deserialize(const char*& begin, const char* end, ArgTs&&...args) -> tuple_type
           {
             using field_type = cpp::tuple_element_t<I, tuple_type>;
             auto field = Field<field_type>::deserialize(begin, end);
-            return MessageDeserializer<I + 1, T>::deserialize(begin, end, cpp::forward<ArgTs>(args)..., field);
+            return MessageDeserializer<I + 1, T>::deserialize(begin, end, cpp::forward<ArgTs>(args)..., cpp::move(field));
+          }
+          static auto deserialize_into(const char*& begin, const char* end, tuple_type& t) -> void
+          {
+            using field_type = cpp::tuple_element_t<I, tuple_type>;
+            detail::deserialize_into<Field<field_type>>(begin, end, cpp::get<I>(t));
+            MessageDeserializer<I + 1, T>::deserialize_into(begin, end, t);
           }
       };
 
@@ -136,122 +348,1249 @@ namespace tpl
       class MessageDeserializer<0, T, cpp::enable_if_t<cpp::tuple_size<T>::value != 0>>
       {
         using tuple_type = T;
-        using string_iter = cpp::string::const_iterator;
       public:
-        static auto deserialize(string_iter& begin, const string_iter& end) -> tuple_type
+        static auto deserialize(const char*& begin, const char* end) -> tuple_type
+          {
+            return deserialize(begin, end, fixed_width {});
+          }
+        static auto deserialize_into(const char*& begin, const char* end, tuple_type& t) -> void
+          {
+            deserialize_into(begin, end, t, fixed_width {});
+          }
+      private:
+        using fixed_width = std::integral_constant<bool, MessageSerializer<0, T>::is_fixed_width>;
+
+        static auto deserialize(const char*& begin, const char* end, std::true_type) -> tuple_type
+          {
+            if(static_cast<size_t>(end - begin) < MessageSerializer<0, T>::fixed_size)
+            {
+              detail::throw_error<std::length_error>("read past end");
+            }
+            auto result = FixedMessageCodec<0, T>::deserialize(begin);
+            begin += MessageSerializer<0, T>::fixed_size;
+            return result;
+          }
+        static auto deserialize(const char*& begin, const char* end, std::false_type) -> tuple_type
           {
             using field_type = cpp::tuple_element_t<0, tuple_type>;
             auto field = Field<field_type>::deserialize(begin, end);
-            return MessageDeserializer<1, T>::deserialize(begin, end, field);
+            return MessageDeserializer<1, T>::deserialize(begin, end, cpp::move(field));
+          }
+        // Fixed-width fields own no storage to reuse.
+        static auto deserialize_into(const char*& begin, const char* end, tuple_type& t, std::true_type) -> void
+          {
+            t = deserialize(begin, end, std::true_type {});
+          }
+        static auto deserialize_into(const char*& begin, const char* end, tuple_type& t, std::false_type) -> void
+          {
+            using field_type = cpp::tuple_element_t<0, tuple_type>;
+            detail::deserialize_into<Field<field_type>>(begin, end, cpp::get<0>(t));
+            MessageDeserializer<1, T>::deserialize_into(begin, end, t);
           }
       };
 
   } /* namespace detail */
 /*********************************************************************************************************************
-* Implementation of `protocol::definition::visitor` class.
+* Compile-time integer sequences (`std::index_sequence` is C++14) and the ID-to-tuple-index lookup used to build the
+* visitor's dispatch table.
+*
+* `message_index_from` yields the tuple index of the `Message` whose ID is `ID`, or the size of the tuple when no
+* `Message` with that ID was supplied to the `definition`.
 *********************************************************************************************************************/
   namespace detail {
-    
-      template<size_t I, typename MT, typename EnableT = void>
-      class protocol_visitor;
 
-      template<size_t I, typename MT>
-      class protocol_visitor<I, MT, cpp::enable_if_t<I == cpp::tuple_size<MT>::value>>
+    template<size_t...Is>
+    struct index_sequence {};
+
+    namespace impl
+    {
+      template<size_t N, size_t...Is>
+      struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...> {};
+
+      template<size_t...Is>
+      struct make_index_sequence<0, Is...>
       {
-      protected:
-        using string_iter = cpp::string::const_iterator;
-        auto do_accept(char id, string_iter& begin, const string_iter& end) -> void {}
+        using type = index_sequence<Is...>;
       };
-      template<size_t I, typename MT>
-      class protocol_visitor<I, MT, cpp::enable_if_t<I != 0 && I != cpp::tuple_size<MT>::value>> 
-        : public protocol_visitor<I + 1, MT>
+
+      template<size_t ID, size_t IndexN, typename T, typename En = void>
+      class message_index_from;
+
+      template<size_t ID, size_t IndexN, typename T>
+      class message_index_from<ID, IndexN, T, cpp::enable_if_t<cpp::tuple_size<T>::value == IndexN>>
       {
-        using message_type = cpp::tuple_element_t<I, MT>;
-        virtual auto visit(const message_type&) -> void = 0;
-        using string_iter = cpp::string::const_iterator;
       public:
-        auto do_accept(char id, string_iter& begin, const string_iter& end) -> void
+        static constexpr size_t value = IndexN;
+      };
+
+      template<size_t ID, size_t IndexN, typename T>
+      class message_index_from<ID, IndexN, T, cpp::enable_if_t<cpp::tuple_size<T>::value != IndexN>>
+      {
+        using type_at_index = cpp::tuple_element_t<IndexN, T>;
+      public:
+        static constexpr size_t value = ID == static_cast<size_t>(type_at_index::message_type_id())
+                                      ? IndexN
+                                      : message_index_from<ID, IndexN + 1, T>::value;
+      };
+    } // namespace impl
+
+    template<size_t N>
+      using make_index_sequence = typename impl::make_index_sequence<N>::type;
+
+    template<size_t ID, typename TupleT>
+      using message_index_from = impl::message_index_from<ID, 0, TupleT>;
+
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of `message_view` class, which decodes the fields of an encoded `Message` one at a time, on demand.
+*
+* The offset of each field in the leading run of fixed-width fields is a compile-time constant.  Beyond the first
+* variable-width field, offsets are found by skipping the fields before them (see `Field::skip`), and cached, so that
+* each field is skipped at most once over the life of the view.
+*********************************************************************************************************************/
+  namespace detail {
+
+      template<typename TupleT, size_t I, bool InRangeV = (I < cpp::tuple_size<TupleT>::value)>
+      struct is_fixed_width_field : std::false_type {};
+
+      template<typename TupleT, size_t I>
+      struct is_fixed_width_field<TupleT, I, true> : std::integral_constant<bool, Field<cpp::tuple_element_t<I, TupleT>>::is_fixed_width> {};
+
+      /*!
+       * \brief The number of leading fixed-width fields in a field tuple, and their total size.
+       */
+      template<typename TupleT, size_t I = 0, typename EnableT = void>
+      struct fixed_field_prefix
+      {
+        static constexpr size_t length = I;
+        static constexpr size_t size   = 0;
+      };
+
+      template<typename TupleT, size_t I>
+      struct fixed_field_prefix<TupleT, I, cpp::enable_if_t<is_fixed_width_field<TupleT, I>::value>>
+      {
+        static constexpr size_t length = fixed_field_prefix<TupleT, I + 1>::length;
+        static constexpr size_t size   = Field<cpp::tuple_element_t<I, TupleT>>::fixed_size + fixed_field_prefix<TupleT, I + 1>::size;
+      };
+
+      /*!
+       * \brief The compile-time offset of field `I`, which must lie within the leading run of fixed-width fields or be
+       *        the first field after it.
+       */
+      template<typename TupleT, size_t I>
+      struct fixed_field_offset
+      {
+        static constexpr size_t value = Field<cpp::tuple_element_t<I - 1, TupleT>>::fixed_size + fixed_field_offset<TupleT, I - 1>::value;
+      };
+
+      template<typename TupleT>
+      struct fixed_field_offset<TupleT, 0>
+      {
+        static constexpr size_t value = 0;
+      };
+  } /* namespace detail */
+
+  /*!
+   * \brief A read-only view of the encoded fields of a `MessageT`, which decodes only the fields that are asked for.
+   *
+   *        Where a handler needs a few fields to decide what to do with a message--or whether to drop it--a view
+   *        saves decoding the rest.  The view refers to the encoded bytes, which must outlive it; `decode` produces
+   *        the whole message.
+   */
+  template<typename MessageT>
+  class message_view
+  {
+    using field_tuple = typename MessageT::field_tuple_type;
+    using skip_type   = auto (*)(const char*&, const char*) -> size_t;
+
+    static constexpr size_t field_count  = cpp::tuple_size<field_tuple>::value;
+    static constexpr size_t fixed_length = detail::fixed_field_prefix<field_tuple>::length;
+    static constexpr size_t fixed_size   = detail::fixed_field_prefix<field_tuple>::size;
+  public:
+    using message_type = MessageT;
+    template<size_t I>
+      using field_type = cpp::tuple_element_t<I, field_tuple>;
+
+    /*!
+     * \brief Views the fields encoded in `[begin, end)`, i.e. a message without its ID (and frame header, if any).
+     */
+    message_view(const char* begin, const char* end)
+      : begin_(begin), end_(end), known_(fixed_length)
+      {
+        // If the fixed-width fields don't fit, any field after them is past the end, and will fail to skip.
+        offsets_[fixed_length] = static_cast<size_t>(end - begin) < fixed_size? end : begin + fixed_size;
+      }
+
+    static constexpr auto message_type_id() -> decltype(MessageT::message_type_id()) { return MessageT::message_type_id(); }
+
+    /*!
+     * \brief Decodes field `I`.
+     */
+    template<size_t I>
+    auto get() const -> field_type<I>
+      {
+        static_assert(I < field_count, "field index out of range");
+        auto p = field_begin<I>();
+        return Field<field_type<I>>::deserialize(p, end_);
+      }
+    /*!
+     * \brief Decodes every field, into a `MessageT`.
+     */
+    auto decode() const -> MessageT
+      {
+        auto p = begin_;
+        return MessageT { detail::MessageDeserializer<0, field_tuple>::deserialize(p, end_) };
+      }
+    auto data() const -> const char* { return begin_; }
+    auto size() const -> size_t { return static_cast<size_t>(end_ - begin_); }
+  private:
+    template<size_t I, cpp::enable_if_t<(I <= fixed_length), int> = 0>
+    auto field_begin() const -> const char*
+      {
+        constexpr size_t offset = detail::fixed_field_offset<field_tuple, I>::value;
+        if(static_cast<size_t>(end_ - begin_) < offset)
+        {
+          detail::throw_error<std::length_error>("read past end");
+        }
+        return begin_ + offset;
+      }
+    template<size_t I, cpp::enable_if_t<(I > fixed_length), int> = 0>
+    auto field_begin() const -> const char*
+      {
+        if(known_ < I)
+        {
+          auto skips = skip_table(detail::make_index_sequence<field_count>{});
+          auto p     = offsets_[known_];
+          for(auto k = known_; k < I; ++k)
           {
-            if(begin >= end)
-            {
-              throw std::length_error("read past end");
-            }
-            if(id == static_cast<char>(message_type::message_type_id()))
+            if(skips[k](p, end_) != 0)
             {
-              visit(message_type { MessageDeserializer<0, typename message_type::field_tuple_type>::deserialize(++begin, end) });
+              detail::throw_error<std::length_error>("read past end");
             }
-            else
+            offsets_[k + 1] = p;
+          }
+          known_ = I;
+        }
+        return offsets_[I];
+      }
+    template<size_t...Is>
+    static auto skip_table(detail::index_sequence<Is...>) -> const skip_type*
+      {
+        static constexpr skip_type table[] = { &Field<field_type<Is>>::skip... };
+        return table;
+      }
+
+    const char*                                      begin_;
+    const char*                                      end_;
+    mutable size_t                                   known_;
+    mutable std::array<const char*, field_count + 1> offsets_;
+  };
+
+/*********************************************************************************************************************
+* Wire framing policies for `protocol::basic_definition`.
+*
+* Unframed messages are encoded as `[id][fields...]`; only the fields themselves say where a message ends.
+*
+* Length-prefixed messages are encoded as `[id][length][fields...]`, where `length` is a `varint` count of the bytes of
+* the fields.  The length lets a decoder step over messages of unknown or unwanted types without decoding them, and
+* confines each message's field decoders to its own frame.  Bytes left in a frame after its fields are decoded are
+* ignored, so producers may append fields to a message without breaking older consumers.
+*********************************************************************************************************************/
+  namespace framing {
+    struct none {};
+    struct length_prefixed {};
+  } // namespace framing
+
+  namespace detail {
+
+      template<typename FramingT>
+      class framer;
+
+      template<>
+      class framer<framing::none>
+      {
+      public:
+        static constexpr bool is_framed = false;
+
+        static auto frame_size(size_t body_size) -> size_t
+          {
+            return 1 + body_size;
+          }
+        static auto write_header(char*& out, char id, size_t body_size) -> void
+          {
+            *out++ = id;
+          }
+        /*!
+         * \brief Advances `begin` past the header of the message at `begin`, and returns the end of its body--which,
+         *        without framing, is not known, so is just `end`.
+         */
+        static auto read_header(const char*& begin, const char* end) -> const char*
+          {
+            ++begin;
+            return end;
+          }
+        /*!
+         * \brief As `read_header`, but with the contract of `Field::skip`: returns 0 and sets `body_end`, or reports
+         *        what is missing without advancing `begin`.
+         */
+        static auto try_read_header(const char*& begin, const char* end, const char*& body_end) -> size_t
+          {
+            if(begin >= end)
             {
-              protocol_visitor<I + 1, MT>::do_accept(id, begin, end);
+              return 1;
             }
+            ++begin;
+            body_end = end;
+            return 0;
           }
       };
-      template<typename MT>
-      class protocol_visitor<0, MT> 
-        : public protocol_visitor<1, MT>
+
+      template<>
+      class framer<framing::length_prefixed>
       {
-        using message_type = cpp::tuple_element_t<0, MT>;
+        using length_field = Field<varint<size_t>>;
       public:
-        auto accept(const cpp::string& s) -> void
+        static constexpr bool is_framed = true;
+
+        static auto frame_size(size_t body_size) -> size_t
           {
-            if(s.empty()) return;
-            auto begin = s.begin();
-            auto end   = s.end();
-            while(begin < end)
+            return 1 + length_field::serialized_size(body_size) + body_size;
+          }
+        static auto write_header(char*& out, char id, size_t body_size) -> void
+          {
+            *out++ = id;
+            length_field::serialize(out, body_size);
+          }
+        static auto read_header(const char*& begin, const char* end) -> const char*
+          {
+            const char* body_end = nullptr;
+            if(try_read_header(begin, end, body_end) == 0)
             {
-              auto ch = *begin;
-              do_accept(ch, begin, end);
+              return body_end;
             }
+            // Report what is wrong with the header.
+            ++begin;
+            size_t length = length_field::deserialize(begin, end);
+            if(static_cast<size_t>(end - begin) < length)
+            {
+              detail::throw_error<std::length_error>("frame length greater than remaining stream length");
+            }
+            return begin + length;
           }
-      protected:
-        using string_iter = cpp::string::const_iterator;
-        auto do_accept(char id, string_iter& begin, const string_iter& end) -> void
+        static auto try_read_header(const char*& begin, const char* end, const char*& body_end) -> size_t
           {
-            if(begin >= end)
+            if(end - begin < 2)
             {
-              throw std::length_error("read past end");
+              return 2 - static_cast<size_t>(end - begin);
             }
-            if(id == static_cast<char>(message_type::message_type_id()))
+            auto   p = begin + 1;
+            size_t length;
+            // Most frames are short enough for a single-byte length, which is worth a branch when scanning.
+            if(static_cast<unsigned char>(*p) < 0x80)
             {
-              visit(message_type { MessageDeserializer<0, typename message_type::field_tuple_type>::deserialize(++begin, end) });
+              length = static_cast<unsigned char>(*p++);
             }
             else
             {
-              protocol_visitor<1, MT>::do_accept(id, begin, end);
+              auto missing = length_field::skip(p, end);
+              if(missing != 0)
+              {
+                return missing;
+              }
+              p      = begin + 1;
+              length = length_field::deserialize(p, end);
             }
+            auto available = static_cast<size_t>(end - p);
+            if(available < length)
+            {
+              return length - available;
+            }
+            begin    = p;
+            body_end = p + length;
+            return 0;
+          }
+        /*!
+         * \brief Same contract as `Field::skip`, for the whole frame at `begin`; it needs only the header.
+         */
+        static auto skip(const char*& begin, const char* end) -> size_t
+          {
+            auto        p        = begin;
+            const char* body_end = nullptr;
+            auto        missing  = try_read_header(p, end, body_end);
+            if(missing == 0)
+            {
+              begin = body_end;
+            }
+            return missing;
           }
-      private:
-        virtual auto visit(const message_type&) -> void = 0;
       };
-  } /* namespace detail */
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of `decode_result`, and of the checks behind the non-throwing decoders (`definition::try_dispatch`,
+* `visitor::try_accept`).
+*
+* A message is checked with the `skip` functions, which never throw; a message which skips decodes without error, so a
+* malformed or truncated one is reported without any of it being passed on.  Skipping reads only lengths and varints--
+* fixed-width fields and whole fixed-width messages are a single comparison--and `visitor::try_accept` checks every
+* message before it is decoded.  `try_dispatch` does so too when exceptions are disabled; otherwise a variable-width
+* message decoded whole, which its decode bounds as tightly as the check would, is decoded first, and checked only if
+* that fails, to say why (see `static_dispatcher::checked_on_failure`).
+*********************************************************************************************************************/
+  /*!
+   * \brief Why a non-throwing decode stopped.
+   */
+  enum class decode_status
+  {
+    ok,             //!< The input was decoded to its end.
+    truncated,      //!< The input ends partway through a message.
+    unknown_id,     //!< An unframed message has an ID which matches no message type, so it cannot be decoded or skipped.
+    invalid_length  //!< A length or varint is malformed, or a frame is too short for the message it holds.
+  };
 
   /*!
-   * \brief The `protocol` class associates a message protocol with an id-type, which can be any type which can be
-   *        used--either directly or via conversion--as a tuple-index and is deterministic at compile-time.
-   *
-   *        This class provides the `definition` sub-class, which permits assignment of concrete `Message` definitions
-   *        that are used to implement serialization methods.
+   * \brief The outcome of a non-throwing decode.
    */
-  template<typename ET>
-  class protocol
+  struct decode_result
   {
-    using message_id_type = ET;
-  public:
-    /*!
-     * \brief The `Message` sub-class describes the data types which are stored in a message; it is used by the
-     *        serializer methods to pack message objects into their binary representations, which are stored in a 
-     *        standard string.
-     */
-    template<message_id_type MessageTypeID, typename...MessageFieldTypes>
-    class Message
-    {
-    public:
-      using message_id_type = ET;
-      using field_tuple_type  = cpp::tuple<MessageFieldTypes...>;
+    decode_status status;
+    size_t        offset;        //!< The number of bytes consumed: the input size, or where the offending message begins.
+    size_t        bytes_needed;  //!< If `truncated`, a lower bound on the number of bytes which must follow the input.
+
+    explicit operator bool() const { return status == decode_status::ok; }
+  };
+
+  namespace detail {
+
+      template<typename MT, typename FramingT>
+      class message_checker
+      {
+        using framer_type = framer<FramingT>;
+        using check_type  = auto (*)(const char*, const char*, size_t&) -> decode_status;
+
+        static auto failure(size_t missing, bool within_frame, size_t& needed) -> decode_status
+          {
+            if(missing == skip_invalid || within_frame)
+            {
+              return decode_status::invalid_length;
+            }
+            needed = missing;
+            return decode_status::truncated;
+          }
+        template<size_t...IDs>
+        static auto check_table(index_sequence<IDs...>) -> const check_type*
+          {
+            static constexpr check_type table[] = { &check<message_index_from<IDs, MT>::value>... };
+            return table;
+          }
+      public:
+        /*!
+         * \brief Checks the header of the message at `begin`, and advances `begin` past it to the body.
+         */
+        static auto check_header(const char*& begin, const char* end, const char*& body_end, size_t& needed) -> decode_status
+          {
+            auto missing = framer_type::try_read_header(begin, end, body_end);
+            return missing == 0? decode_status::ok : failure(missing, false, needed);
+          }
+        /*!
+         * \brief Checks the body at `begin` of a message of type `I`--or, if `I` is the number of message types, of
+         *        unknown type--without decoding it.
+         */
+        template<size_t I, cpp::enable_if_t<I != cpp::tuple_size<MT>::value, int> = 0>
+        static auto check_body(const char* begin, const char* body_end, size_t& needed) -> decode_status
+          {
+            auto missing = MessageSkipper<0, typename cpp::tuple_element_t<I, MT>::field_tuple_type>::skip(begin, body_end);
+            return missing == 0? decode_status::ok : failure(missing, framer_type::is_framed, needed);
+          }
+        template<size_t I, cpp::enable_if_t<I == cpp::tuple_size<MT>::value, int> = 0>
+        static auto check_body(const char* begin, const char* body_end, size_t& needed) -> decode_status
+          {
+            return framer_type::is_framed? decode_status::ok : decode_status::unknown_id;
+          }
+        template<size_t I>
+        static auto check(const char* begin, const char* end, size_t& needed) -> decode_status
+          {
+            const char* body_end = nullptr;
+            auto status = check_header(begin, end, body_end, needed);
+            return status == decode_status::ok? check_body<I>(begin, body_end, needed) : status;
+          }
+        /*!
+         * \brief Checks the message at `begin`, whatever its type; `begin` must be short of `end`.
+         */
+        static auto check(const char* begin, const char* end, size_t& needed) -> decode_status
+          {
+            auto table = check_table(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            return table[static_cast<unsigned char>(*begin)](begin, end, needed);
+          }
+      };
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of stats policy hooks.
+*
+* A definition's stats policy (see `definition::with_stats`) is told of each message which its decoders and encoders
+* handle, through `stats_hooks`.  The hooks for the default, `null_stats`, do nothing and are empty, so that every call
+* to them compiles away.  The hooks for any other policy `S` keep one `S`, created on first use from the message IDs of
+* the definition's types (in definition order), and obtain from it one `S::slot` per thread, on the thread's first use.
+* Of a policy, they require:
+*
+*   - `S(std::vector<size_t> message_ids)`, and `auto register_thread() -> slot&`, which is called once per thread;
+*   - `batch<N>(slot&)`, where `N` is the number of message types, created at the start of each decoding call and
+*     destroyed at its end, so that it may count the call's messages in locals and record them all at once;
+*   - `batch<N>::probe(batch&, size_t index, const char* begin)`, created as a message of type `index` begins to
+*     decode at `begin`; then `decoded(const char* end)` is called once it is decoded, and `visited()` once it is
+*     handled.  A probe which is destroyed without `decoded` having been called--because decoding threw--marks a
+*     decode failure;
+*   - `batch<N>::timed(size_t index)`, whether the next message of type `index` is to be timed, and if so,
+*     `batch<N>::timed_probe`, which is used as `probe` is.  A timed message is decoded and handled on a path of its
+*     own, so that what the timing costs falls on it alone;
+*   - `batch<N>::failed(size_t index)`, for a message which a non-throwing decoder rejected as malformed--or, if
+*     `index` is `N`, for an ID which matches none;
+*   - `slot::encoded(size_t index, size_t bytes)`, for each message encoded through `definition::serialize`.
+*********************************************************************************************************************/
+  /*!
+   * \brief The default stats policy, which records nothing and costs nothing.
+   */
+  struct null_stats {};
+
+  namespace detail {
+
+      template<typename StatsT, typename MT, typename FramingT>
+      class stats_hooks
+      {
+        using stats_type = StatsT;
+        using slot_type  = typename StatsT::slot;
+        using batch_type = typename StatsT::template batch<cpp::tuple_size<MT>::value>;
+
+        template<size_t...Is>
+        static auto message_ids(index_sequence<Is...>) -> std::vector<size_t>
+          {
+            return std::vector<size_t> { static_cast<size_t>(cpp::tuple_element_t<Is, MT>::message_type_id())... };
+          }
+        template<size_t...IDs>
+        static auto index_table(index_sequence<IDs...>) -> const size_t*
+          {
+            static constexpr size_t table[] = { message_index_from<IDs, MT>::value... };
+            return table;
+          }
+      public:
+        static auto stats() -> stats_type&
+          {
+            static stats_type instance(message_ids(make_index_sequence<cpp::tuple_size<MT>::value>{}));
+            return instance;
+          }
+        /*
+         * A pointer, rather than a reference initialized on first use, so that each use is a plain thread-local load
+         * rather than a call to check whether it has been initialized.
+         */
+        static auto local() -> slot_type&
+          {
+            static thread_local slot_type* slot = nullptr;
+            if(slot == nullptr)
+            {
+              slot = &stats().register_thread();
+            }
+            return *slot;
+          }
+        class batch : public batch_type
+        {
+        public:
+          batch()
+            : batch_type(local())
+            {}
+        };
+        using probe       = typename batch_type::probe;
+        using timed_probe = typename batch_type::timed_probe;
+        /*!
+         * \brief Records a message, beginning with ID `id`, which a non-throwing decoder rejected with `status`; a
+         *        truncated message is not a failure, since the rest of it may yet arrive.
+         */
+        static auto rejected(batch& b, char id, decode_status status) -> void
+          {
+            if(status != decode_status::truncated)
+            {
+              b.failed(index_table(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{})[static_cast<unsigned char>(id)]);
+            }
+          }
+        static auto encoded(size_t index, size_t bytes) -> void
+          {
+            local().encoded(index, bytes);
+          }
+      };
+      template<typename MT, typename FramingT>
+      class stats_hooks<null_stats, MT, FramingT>
+      {
+      public:
+        struct batch
+        {
+          static constexpr auto timed(size_t) -> bool { return false; }
+          auto failed(size_t) -> void {}
+        };
+        struct probe
+        {
+          probe(batch&, size_t, const char*) {}
+          auto decoded(const char*) -> void {}
+          auto visited() -> void {}
+        };
+        using timed_probe = probe;
+        static auto rejected(batch&, char, decode_status) -> void {}
+        static auto encoded(size_t, size_t) -> void {}
+      };
+  } // namespace detail
+/*********************************************************************************************************************
+* Implementation of `protocol::definition::visitor` class.
+*
+* Each level of the inheritance chain declares the pure-virtual `visit` overload for one message type, along with a
+* static `dispatch` thunk which decodes that message type and visits it.  Each level also holds a message of its type
+* which every decode of that type reuses, so that once its string and sequence fields have grown to fit, decoding
+* allocates nothing; the message passed to `visit` is therefore only valid until the next message of its type.  The
+* terminal level's `dispatch` handles IDs for which no message type exists.  `accept` indexes a table of these
+* thunks--one entry per possible ID byte, generated at compile-time--so that dispatch cost does not depend upon the
+* number of message types in the protocol.  A parallel table of `skip` thunks finds where each unframed message ends
+* without decoding it, for use on partial input.
+*********************************************************************************************************************/
+  namespace detail {
+    
+      template<size_t I, typename MT, typename FramingT, typename StatsT = null_stats, typename EnableT = void>
+      class protocol_visitor;
+
+      template<size_t I, typename MT, typename FramingT, typename StatsT>
+      class protocol_visitor<I, MT, FramingT, StatsT, cpp::enable_if_t<I == cpp::tuple_size<MT>::value>>
+      {
+      protected:
+        using batch_type    = typename stats_hooks<StatsT, MT, FramingT>::batch;
+        using dispatch_type = auto (*)(protocol_visitor&, batch_type&, char, const char*&, const char*) -> void;
+
+        /*
+         * `end` is the end of the frame, if the protocol is framed; otherwise, there is no way to find the start of
+         * the next message, so the rest of the input is discarded.
+         */
+        static auto dispatch(protocol_visitor& self, batch_type& batch, char id, const char*& begin, const char* end) -> void
+          {
+            batch.failed(I);
+            self.visit_unknown(id);
+            begin = end;
+          }
+        using skip_type = auto (*)(const char*&, const char*) -> size_t;
+
+        /*
+         * The length of an unframed message with an unknown ID can't be determined, so it is reported as complete;
+         * dispatching it then reaches `visit_unknown`.
+         */
+        static auto skip(const char*& begin, const char* end) -> size_t
+          {
+            return 0;
+          }
+      private:
+        /*!
+         * \brief Called when the ID byte at the head of a message matches no message type in the protocol.
+         *
+         *        By default, an unframed protocol throws `std::invalid_argument`, since the input cannot be decoded
+         *        any further; if an override returns instead, the remainder of the input is discarded.  A framed
+         *        protocol skips the message by default.
+         */
+        virtual auto visit_unknown(char id) -> void
+          {
+            if(!framer<FramingT>::is_framed)
+            {
+              detail::throw_error<std::invalid_argument>("unknown message id");
+            }
+          }
+      };
+      template<size_t I, typename MT, typename FramingT, typename StatsT>
+      class protocol_visitor<I, MT, FramingT, StatsT, cpp::enable_if_t<I != cpp::tuple_size<MT>::value>> 
+        : public protocol_visitor<I + 1, MT, FramingT, StatsT>
+      {
+        using message_type = cpp::tuple_element_t<I, MT>;
+        using base_type    = protocol_visitor<cpp::tuple_size<MT>::value, MT, FramingT, StatsT>;
+        using framer_type  = framer<FramingT>;
+        using stats_hooks  = detail::stats_hooks<StatsT, MT, FramingT>;
+        using batch_type   = typename stats_hooks::batch;
+        virtual auto visit(const message_type&) -> void = 0;
+      public:
+        template<size_t N = I, typename = cpp::enable_if_t<N == 0>>
+        auto accept(const cpp::string& s) -> void
+          {
+            accept(s.data(), s.size());
+          }
+        /*!
+         * \brief Decodes and visits each message in the `size` bytes at `data`, which may lie in any memory region.
+         */
+        template<size_t N = I, typename = cpp::enable_if_t<N == 0>>
+        auto accept(const char* data, size_t size) -> void
+          {
+            auto       table = dispatch_table(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            auto       begin = data;
+            auto       end   = data + size;
+            batch_type batch;
+            while(begin < end)
+            {
+              dispatch_one(table, batch, begin, end);
+            }
+          }
+        /*!
+         * \brief Like `accept`, but stops without error at a final message which is cut off by the end of the input.
+         *
+         * \return The number of bytes consumed, i.e. the offset of the incomplete message, if any.
+         */
+        template<size_t N = I, typename = cpp::enable_if_t<N == 0>>
+        auto accept_complete(const char* data, size_t size) -> size_t
+          {
+            auto       table = dispatch_table(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            auto       begin = data;
+            auto       end   = data + size;
+            batch_type batch;
+            while(begin < end)
+            {
+              auto missing = bytes_missing(begin, static_cast<size_t>(end - begin));
+              if(missing != 0 && missing != skip_invalid)
+              {
+                break;
+              }
+              dispatch_one(table, batch, begin, end);
+            }
+            return static_cast<size_t>(begin - data);
+          }
+        /*!
+         * \brief Like `accept`, but never throws on malformed input: decoding stops before the first message which is
+         *        truncated, malformed, or (if unframed) of unknown type, and the result says which and where.  A
+         *        framed message of unknown type is passed to `visit_unknown`, as by `accept`.
+         */
+        template<size_t N = I, typename = cpp::enable_if_t<N == 0>>
+        auto try_accept(const char* data, size_t size) -> decode_result
+          {
+            auto       table = dispatch_table(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            auto       begin = data;
+            auto       end   = data + size;
+            batch_type batch;
+            while(begin < end)
+            {
+              size_t needed = 0;
+              auto   status = message_checker<MT, FramingT>::check(begin, end, needed);
+              if(status != decode_status::ok)
+              {
+                stats_hooks::rejected(batch, *begin, status);
+                return decode_result { status, static_cast<size_t>(begin - data), needed };
+              }
+              dispatch_one(table, batch, begin, end);
+            }
+            return decode_result { decode_status::ok, size, 0 };
+          }
+        /*!
+         * \brief A lower bound on the number of bytes which must follow the `size` bytes at `data` to complete the
+         *        message which begins at `data`, or 0 if the message is already complete, or `skip_invalid` if it
+         *        is malformed.
+         */
+        template<size_t N = I, typename = cpp::enable_if_t<N == 0>>
+        auto bytes_missing(const char* data, size_t size) const -> size_t
+          {
+            return bytes_missing(data, data + size, FramingT {});
+          }
+      protected:
+        using dispatch_type = typename protocol_visitor<I + 1, MT, FramingT, StatsT>::dispatch_type;
+        using skip_type     = typename protocol_visitor<I + 1, MT, FramingT, StatsT>::skip_type;
+
+        static auto dispatch(base_type& self, batch_type& batch, char id, const char*& begin, const char* end) -> void
+          {
+            auto& visitor = static_cast<protocol_visitor&>(self);
+            // As for `definition::dispatch`, a message which the stats policy times takes a path of its own.
+            if(batch.timed(I))
+            {
+              visit_timed(visitor, batch, begin, end);
+            }
+            else
+            {
+              visit_probed<typename stats_hooks::probe>(visitor, batch, begin, end);
+            }
+          }
+        TEMPLAR_COLD static auto visit_timed(protocol_visitor& visitor, batch_type& batch, const char*& begin, const char* end) -> void
+          {
+            visit_probed<typename stats_hooks::timed_probe>(visitor, batch, begin, end);
+          }
+        template<typename ProbeT>
+        static auto visit_probed(protocol_visitor& visitor, batch_type& batch, const char*& begin, const char* end) -> void
+          {
+            ProbeT probe(batch, I, begin);
+            MessageDeserializer<0, typename message_type::field_tuple_type>::deserialize_into(begin, end, visitor.slot_.fields());
+            probe.decoded(begin);
+            visitor.visit(visitor.slot_);
+            probe.visited();
+          }
+        static auto skip(const char*& begin, const char* end) -> size_t
+          {
+            auto p       = begin + 1;
+            auto missing = MessageSkipper<0, typename message_type::field_tuple_type>::skip(p, end);
+            if(missing == 0)
+            {
+              begin = p;
+            }
+            return missing;
+          }
+      private:
+        auto dispatch_one(const dispatch_type* table, batch_type& batch, const char*& begin, const char* end) -> void
+          {
+            auto id       = *begin;
+            auto body_end = framer_type::read_header(begin, end);
+            table[static_cast<unsigned char>(id)](*this, batch, id, begin, body_end);
+            if(framer_type::is_framed)
+            {
+              begin = body_end;
+            }
+          }
+        static auto bytes_missing(const char* begin, const char* end, framing::none) -> size_t
+          {
+            if(begin >= end)
+            {
+              return 1;
+            }
+            auto skips = skip_table(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            return skips[static_cast<unsigned char>(*begin)](begin, end);
+          }
+        static auto bytes_missing(const char* begin, const char* end, framing::length_prefixed) -> size_t
+          {
+            return framer_type::skip(begin, end);
+          }
+        template<size_t...IDs>
+        static auto dispatch_table(index_sequence<IDs...>) -> const dispatch_type*
+          {
+            static constexpr dispatch_type table[] = { &protocol_visitor<message_index_from<IDs, MT>::value, MT, FramingT, StatsT>::dispatch... };
+            return table;
+          }
+        template<size_t...IDs>
+        static auto skip_table(index_sequence<IDs...>) -> const skip_type*
+          {
+            static constexpr skip_type table[] = { &protocol_visitor<message_index_from<IDs, MT>::value, MT, FramingT, StatsT>::skip... };
+            return table;
+          }
+
+        message_type slot_;
+      };
+  } /* namespace detail */
+/*********************************************************************************************************************
+* Implementation of `protocol::definition::dispatch`, the non-virtual alternative to `protocol::definition::visitor`.
+*
+* The handler is any callable with an overload for each message type.  Dispatch goes through a table of thunks indexed
+* by ID byte, as for the visitor, but each thunk is instantiated for the handler's concrete type, so the handler's
+* overloads are called directly and can be inlined into the thunk--the table being, in effect, the jump table of a
+* switch over the message ID.  The visitor remains available where runtime polymorphism is wanted.
+*
+* A handler may take a `message_view` of a message type instead of the message, in which case only the fields it reads
+* are decoded.  In a framed protocol, the handler need only be callable with the message types it is interested in; the
+* others are skipped without being decoded.
+*********************************************************************************************************************/
+  namespace detail {
+
+      /*!
+       * \brief The default handler for IDs which match no message type.
+       */
+      template<typename FramingT>
+      struct default_unknown_message
+      {
+        auto operator()(char id) const -> void
+          {
+            if(!framer<FramingT>::is_framed)
+            {
+              detail::throw_error<std::invalid_argument>("unknown message id");
+            }
+          }
+      };
+
+      template<typename F, typename ArgT, typename EnableT = void>
+      struct is_callable_with : std::false_type {};
+
+      template<typename F, typename ArgT>
+      struct is_callable_with<F, ArgT, decltype(void(std::declval<F&>()(std::declval<ArgT>())))> : std::true_type {};
+
+      template<typename MT, typename FramingT, typename StatsT = null_stats>
+      class static_dispatcher
+      {
+        using framer_type = framer<FramingT>;
+        using stats_hooks = detail::stats_hooks<StatsT, MT, FramingT>;
+        using batch_type  = typename stats_hooks::batch;
+
+        template<typename HandlerT, typename UnknownT>
+          using dispatch_type = auto (*)(HandlerT&, UnknownT&, batch_type&, char, const char*&, const char*) -> void;
+
+        /*
+         * A handler which takes the message itself gets it decoded; failing that, a handler which takes a
+         * `message_view` gets a view.
+         */
+        template<typename HandlerT, typename MessageT>
+        struct handling : std::integral_constant<int, is_callable_with<HandlerT, MessageT>::value? 2 : is_callable_with<HandlerT, message_view<MessageT>>::value? 1 : 0> {};
+
+        /*
+         * A handler which decodes into a caller-owned message per type, then passes it on by reference.
+         */
+        template<typename HandlerT>
+        struct into_slots
+        {
+          HandlerT& handler;
+          MT&       slots;
+        };
+        template<typename HandlerT, typename MessageT>
+        struct handling<into_slots<HandlerT>, MessageT> : std::integral_constant<int, is_callable_with<HandlerT, const MessageT&>::value? 3 : 0> {};
+
+        template<typename HandlerT, typename MessageT, typename ProbeT>
+        static auto handle(HandlerT& handler, ProbeT& probe, const char*& begin, const char* end, std::integral_constant<int, 3>) -> void
+          {
+            auto& slot = cpp::get<message_index_from<static_cast<size_t>(MessageT::message_type_id()), MT>::value>(handler.slots);
+            MessageDeserializer<0, typename MessageT::field_tuple_type>::deserialize_into(begin, end, slot.fields());
+            probe.decoded(begin);
+            handler.handler(static_cast<const MessageT&>(slot));
+          }
+
+        template<typename HandlerT, typename MessageT, typename ProbeT>
+        static auto handle(HandlerT& handler, ProbeT& probe, const char*& begin, const char* end, std::integral_constant<int, 2>) -> void
+          {
+            MessageT message { MessageDeserializer<0, typename MessageT::field_tuple_type>::deserialize(begin, end) };
+            probe.decoded(begin);
+            handler(cpp::move(message));
+          }
+        /*
+         * A view decodes its fields as they are read, so the decode recorded is of finding where the message ends.
+         */
+        template<typename HandlerT, typename MessageT, typename ProbeT>
+        static auto handle(HandlerT& handler, ProbeT& probe, const char*& begin, const char* end, std::integral_constant<int, 1>) -> void
+          {
+            auto message_end = end;
+            if(!framer_type::is_framed)
+            {
+              // Without a frame, the end of the message is only found by skipping its fields.
+              message_end = begin;
+              if(MessageSkipper<0, typename MessageT::field_tuple_type>::skip(message_end, end) != 0)
+              {
+                detail::throw_error<std::length_error>("read past end");
+              }
+            }
+            probe.decoded(message_end);
+            handler(message_view<MessageT>(begin, message_end));
+            begin = message_end;
+          }
+        template<typename HandlerT, typename MessageT, typename ProbeT>
+        static auto handle(HandlerT& handler, ProbeT& probe, const char*& begin, const char* end, std::integral_constant<int, 0>) -> void
+          {
+            static_assert(framer_type::is_framed && sizeof(MessageT) != 0, "Handler has no overload for a message type; only framed protocols may leave message types unhandled.");
+            probe.decoded(end);
+          }
+        template<size_t I, typename HandlerT, typename UnknownT, cpp::enable_if_t<I != cpp::tuple_size<MT>::value, int> = 0>
+        static auto dispatch_at(HandlerT& handler, UnknownT&, batch_type& batch, char, const char*& begin, const char* end) -> void
+          {
+            // A message which the stats policy times is decoded and handled out of line, apart from the rest, so
+            // that neither reading the clock nor the frame it needs slows the rest, which pass straight to the handler.
+            if(batch.timed(I))
+            {
+              dispatch_timed<I>(handler, batch, begin, end);
+            }
+            else
+            {
+              dispatch_probed<I, typename stats_hooks::probe>(handler, batch, begin, end);
+            }
+          }
+        template<size_t I, typename HandlerT>
+        TEMPLAR_COLD static auto dispatch_timed(HandlerT& handler, batch_type& batch, const char*& begin, const char* end) -> void
+          {
+            dispatch_probed<I, typename stats_hooks::timed_probe>(handler, batch, begin, end);
+          }
+        template<size_t I, typename ProbeT, typename HandlerT>
+        static auto dispatch_probed(HandlerT& handler, batch_type& batch, const char*& begin, const char* end) -> void
+          {
+            using message_type = cpp::tuple_element_t<I, MT>;
+            ProbeT probe(batch, I, begin);
+            handle<HandlerT, message_type>(handler, probe, begin, end, handling<HandlerT, message_type> {});
+            probe.visited();
+          }
+        template<size_t I, typename HandlerT, typename UnknownT, cpp::enable_if_t<I == cpp::tuple_size<MT>::value, int> = 0>
+        static auto dispatch_at(HandlerT&, UnknownT& unknown, batch_type& batch, char id, const char*& begin, const char* end) -> void
+          {
+            batch.failed(I);
+            unknown(id);
+            // As for the visitor: skip the frame, or discard the rest of unframed input.
+            begin = end;
+          }
+        template<typename HandlerT, typename UnknownT>
+          using try_dispatch_type = auto (*)(HandlerT&, UnknownT&, batch_type&, char, const char*&, const char*, size_t&) -> decode_status;
+
+        /*
+         * Whether `try_dispatch` decodes a message of type `I` first, and checks it only if decoding fails: where the
+         * decode itself reads no further than the check would--a message decoded whole, rather than viewed, which is
+         * bounded by its frame or by the input--and where its failure can be caught.  A fixed-width message is
+         * checked by one comparison, which the decode then folds into its own.  With a stats policy, the check comes
+         * first, so that a truncated message, which may yet be completed, is not recorded as a failed decode.
+         */
+        template<size_t I, typename HandlerT, typename EnableT = void>
+        struct checked_on_failure : std::false_type {};
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+        template<size_t I, typename HandlerT>
+        struct checked_on_failure<I, HandlerT, cpp::enable_if_t<I != cpp::tuple_size<MT>::value>>
+          : std::integral_constant<bool, cpp::is_same<StatsT, null_stats>::value
+                                         && !MessageSerializer<0, typename cpp::tuple_element_t<I, MT>::field_tuple_type>::is_fixed_width
+                                         && handling<HandlerT, cpp::tuple_element_t<I, MT>>::value >= 2> {};
+
+        /*
+         * Decodes the message in `[begin, end)` and passes it on, or returns false, having passed on nothing, if it
+         * is malformed or truncated; the handler is called outside the `try`, so that what it throws propagates.
+         */
+        template<typename HandlerT, typename MessageT>
+        static auto try_handle(HandlerT& handler, const char*& begin, const char* end, std::integral_constant<int, 3>) -> bool
+          {
+            auto& slot = cpp::get<message_index_from<static_cast<size_t>(MessageT::message_type_id()), MT>::value>(handler.slots);
+            try
+            {
+              MessageDeserializer<0, typename MessageT::field_tuple_type>::deserialize_into(begin, end, slot.fields());
+            }
+            catch(const std::length_error&)   { return false; }
+            catch(const std::overflow_error&) { return false; }
+            handler.handler(static_cast<const MessageT&>(slot));
+            return true;
+          }
+        template<typename HandlerT, typename MessageT>
+        static auto try_handle(HandlerT& handler, const char*& begin, const char* end, std::integral_constant<int, 2>) -> bool
+          {
+            typename MessageT::field_tuple_type fields;
+            try
+            {
+              fields = MessageDeserializer<0, typename MessageT::field_tuple_type>::deserialize(begin, end);
+            }
+            catch(const std::length_error&)   { return false; }
+            catch(const std::overflow_error&) { return false; }
+            handler(MessageT { cpp::move(fields) });
+            return true;
+          }
+        /*
+         * Only once decoding has failed is the message checked, to say why--and, if it is truncated, by how much; one
+         * which the check passes nonetheless is reported as malformed.
+         */
+        template<size_t I, typename HandlerT, typename UnknownT, cpp::enable_if_t<checked_on_failure<I, HandlerT>::value, int> = 0>
+        static auto try_dispatch_at(HandlerT& handler, UnknownT&, batch_type&, char, const char*& begin, const char* end, size_t& needed) -> decode_status
+          {
+            using message_type = cpp::tuple_element_t<I, MT>;
+            auto body = begin;
+            if(try_handle<HandlerT, message_type>(handler, begin, end, handling<HandlerT, message_type> {}))
+            {
+              return decode_status::ok;
+            }
+            begin = body;
+            auto status = message_checker<MT, FramingT>::template check_body<I>(body, end, needed);
+            return status == decode_status::ok? decode_status::invalid_length : status;
+          }
+#endif
+        /*
+         * Any other message is checked, and only then dispatched.
+         */
+        template<size_t I, typename HandlerT, typename UnknownT, cpp::enable_if_t<!checked_on_failure<I, HandlerT>::value, int> = 0>
+        static auto try_dispatch_at(HandlerT& handler, UnknownT& unknown, batch_type& batch, char id, const char*& begin, const char* end, size_t& needed) -> decode_status
+          {
+            auto status = message_checker<MT, FramingT>::template check_body<I>(begin, end, needed);
+            if(status != decode_status::ok)
+            {
+              if(status != decode_status::truncated)
+              {
+                batch.failed(I);
+              }
+              return status;
+            }
+            dispatch_at<I, HandlerT, UnknownT>(handler, unknown, batch, id, begin, end);
+            return decode_status::ok;
+          }
+        template<typename HandlerT, typename UnknownT, size_t...IDs>
+        static auto try_dispatch_table(index_sequence<IDs...>) -> const try_dispatch_type<HandlerT, UnknownT>*
+          {
+            static constexpr try_dispatch_type<HandlerT, UnknownT> table[] = { &try_dispatch_at<message_index_from<IDs, MT>::value, HandlerT, UnknownT>... };
+            return table;
+          }
+        template<typename HandlerT, typename UnknownT, size_t...IDs>
+        static auto dispatch_table(index_sequence<IDs...>) -> const dispatch_type<HandlerT, UnknownT>*
+          {
+            static constexpr dispatch_type<HandlerT, UnknownT> table[] = { &dispatch_at<message_index_from<IDs, MT>::value, HandlerT, UnknownT>... };
+            return table;
+          }
+      public:
+        template<typename HandlerT, typename UnknownT>
+        static auto dispatch(const char* data, size_t size, HandlerT& handler, UnknownT& unknown) -> void
+          {
+            auto       table = dispatch_table<HandlerT, UnknownT>(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            auto       begin = data;
+            auto       end   = data + size;
+            batch_type batch;
+            while(begin < end)
+            {
+              auto id       = *begin;
+              auto body_end = framer_type::read_header(begin, end);
+              table[static_cast<unsigned char>(id)](handler, unknown, batch, id, begin, body_end);
+              if(framer_type::is_framed)
+              {
+                begin = body_end;
+              }
+            }
+          }
+        /*!
+         * \brief As `dispatch`, but decodes each message into its type's element of `slots`.
+         */
+        template<typename HandlerT, typename UnknownT>
+        static auto dispatch_into(const char* data, size_t size, MT& slots, HandlerT& handler, UnknownT& unknown) -> void
+          {
+            into_slots<HandlerT> adapter { handler, slots };
+            dispatch(data, size, adapter, unknown);
+          }
+        template<typename HandlerT, typename UnknownT>
+        static auto try_dispatch(const char* data, size_t size, HandlerT& handler, UnknownT& unknown) -> decode_result
+          {
+            auto       table = try_dispatch_table<HandlerT, UnknownT>(make_index_sequence<cpp::numeric_limits<unsigned char>::max() + 1>{});
+            auto       begin = data;
+            auto       end   = data + size;
+            batch_type batch;
+            while(begin < end)
+            {
+              auto        id       = *begin;
+              auto        body     = begin;
+              const char* body_end = nullptr;
+              size_t      needed   = 0;
+              auto        status   = message_checker<MT, FramingT>::check_header(body, end, body_end, needed);
+              if(status == decode_status::ok)
+              {
+                status = table[static_cast<unsigned char>(id)](handler, unknown, batch, id, body, body_end, needed);
+              }
+              else
+              {
+                stats_hooks::rejected(batch, id, status);
+              }
+              if(status != decode_status::ok)
+              {
+                return decode_result { status, static_cast<size_t>(begin - data), needed };
+              }
+              begin = framer_type::is_framed? body_end : body;
+            }
+            return decode_result { decode_status::ok, size, 0 };
+          }
+        template<typename HandlerT, typename UnknownT>
+        static auto try_dispatch_into(const char* data, size_t size, MT& slots, HandlerT& handler, UnknownT& unknown) -> decode_result
+          {
+            into_slots<HandlerT> adapter { handler, slots };
+            return try_dispatch(data, size, adapter, unknown);
+          }
+      };
+  } /* namespace detail */
+/*********************************************************************************************************************
+* Implementation of `protocol::definition::stream_decoder` class.
+*********************************************************************************************************************/
+  namespace detail {
+
+      /*!
+       * \brief Decodes a stream which arrives in chunks of arbitrary size, e.g. successive reads from a socket.
+       *
+       *        Each call to `feed` visits every message which the new bytes complete.  Messages lying wholly within
+       *        a chunk are decoded in place; only the bytes of a message which straddles a chunk boundary are copied,
+       *        into an internal buffer which never holds more than one message.  Consequently, a decoded `string_ref`
+       *        field is only valid until its `visit` call returns.
+       */
+      template<typename VisitorT>
+      class stream_decoder
+      {
+      public:
+        explicit stream_decoder(VisitorT& visitor)
+          : visitor_(visitor)
+          {}
+        auto feed(const cpp::string& s) -> void
+          {
+            feed(s.data(), s.size());
+          }
+        auto feed(const char* data, size_t size) -> void
+          {
+            if(!tail_.empty())
+            {
+              auto missing = visitor_.bytes_missing(tail_.data(), tail_.size());
+              while(missing != 0 && missing != skip_invalid)
+              {
+                if(size == 0)
+                {
+                  return;
+                }
+                auto n = std::min(missing, size);
+                tail_.append(data, n);
+                data += n;
+                size -= n;
+                missing = visitor_.bytes_missing(tail_.data(), tail_.size());
+              }
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+              try
+              {
+                visitor_.accept(tail_.data(), tail_.size());
+              }
+              catch(...)
+              {
+                tail_.clear();
+                throw;
+              }
+#else
+              visitor_.accept(tail_.data(), tail_.size());
+#endif
+              tail_.clear();
+            }
+            auto consumed = visitor_.accept_complete(data, size);
+            tail_.assign(data + consumed, size - consumed);
+          }
+        /*!
+         * \brief The number of bytes of an incomplete message which are being held until the rest of it arrives.
+         */
+        auto pending() const -> size_t { return tail_.size(); }
+        /*!
+         * \brief Discards any incomplete message, e.g. after a reconnect.
+         */
+        auto reset() -> void { tail_.clear(); }
+      private:
+        VisitorT&   visitor_;
+        cpp::string tail_;
+      };
+  } /* namespace detail */
+
+  /*!
+   * \brief The `protocol` class associates a message protocol with an id-type, which can be any type which can be
+   *        used--either directly or via conversion--as a tuple-index and is deterministic at compile-time.
+   *
+   *        This class provides the `definition` sub-class, which permits assignment of concrete `Message` definitions
+   *        that are used to implement serialization methods.
+   */
+  template<typename ET>
+  class protocol
+  {
+    using message_id_type = ET;
+  public:
+    /*!
+     * \brief The `Message` sub-class describes the data types which are stored in a message; it is used by the
+     *        serializer methods to pack message objects into their binary representations, which are stored in a 
+     *        standard string.
+     *
+     *        `basic_message` is a `Message` whose string and sequence fields (at any depth) use `AllocatorT`, rebound
+     *        as needed--e.g. `arena_allocator<char>`, to keep decoded payloads in an arena.  The encoding does not
+     *        depend upon the allocator.
+     */
+    template<typename AllocatorT, message_id_type MessageTypeID, typename...MessageFieldTypes>
+    class basic_message
+    {
+    public:
+      using message_id_type = ET;
+      using allocator_type    = AllocatorT;
+      using field_tuple_type  = cpp::tuple<detail::message_field_storage_t<MessageFieldTypes, AllocatorT>...>;
       using char_type         = cpp::string::value_type;
+    private:
+      using id_field          = Field<char_type>;
+      using fields_serializer = detail::MessageSerializer<0, field_tuple_type>;
+    public:
+      /*!
+       * \brief True if every field has a fixed encoded width, in which case `serialized_size()` is `static constexpr`.
+       */
+      static constexpr bool is_fixed_width = fields_serializer::is_fixed_width;
       static constexpr message_id_type message_type_id() { return MessageTypeID; }
-      static_assert(static_cast<size_t>(message_type_id()) < cpp::numeric_limits<char_type>::max(), "Message ID value too large for storage in type 'char'");
-      explicit Message(field_tuple_type&& ft) 
+      static_assert(static_cast<size_t>(message_type_id()) <= cpp::numeric_limits<unsigned char>::max(), "Message ID value too large for storage in type 'char'");
+      basic_message()
+      : fields_()
+      {}
+      /*!
+       * \brief Creates a message whose string and sequence fields use (a copy of) `allocator`.
+       */
+      basic_message(std::allocator_arg_t, const AllocatorT& allocator)
+      : fields_(std::allocator_arg, allocator)
+      {}
+      explicit basic_message(field_tuple_type&& ft) 
       : fields_(cpp::move(ft))
       {}
       auto serialize() const -> cpp::string
@@ -260,14 +1599,61 @@ namespace tpl
           serialize(result);
           return result;
         }
+      /*!
+       * \brief Appends the encoded message to `s`, growing it exactly once.
+       *
+       *        The `serialize` members always produce the unframed encoding; messages of a `framed_definition` are
+       *        encoded through `framed_definition::serialize`.
+       */
       auto serialize(cpp::string& s) const -> void
+        {
+          auto offset = s.size();
+          s.resize(offset + serialized_size());
+          auto out = &s[offset];
+          serialize(out);
+        }
+      /*!
+       * \brief Writes the encoded message at `out`, which must have room for `serialized_size()` bytes, and advances
+       *        `out` past it.
+       */
+      auto serialize(char*& out) const -> void
         {
           static_assert(0 != cpp::tuple_size<field_tuple_type>::value, "");
-          serialize_message_type_id(s);
-          serialize_fields(s);
+          serialize_message_type_id(out);
+          serialize_fields(out);
+        }
+      /*!
+       * \brief Writes the encoded message into a byte sink (see `fixed_buffer`).
+       *
+       * \return false, with nothing written, if the sink cannot hold the whole message.
+       */
+      template<typename SinkT>
+        auto serialize(SinkT& sink) const -> bool
+        {
+          auto out = sink.prepare(serialized_size());
+          if(out == nullptr)
+          {
+            return false;
+          }
+          serialize(out);
+          return true;
+        }
+      /*!
+       * \brief The number of bytes that `serialize` writes, including the message ID.
+       */
+      template<bool FixedWidthV = is_fixed_width, cpp::enable_if_t<FixedWidthV, int> = 0>
+        static constexpr auto serialized_size() -> size_t
+        {
+          return id_field::fixed_size + fields_serializer::fixed_size;
         }
-      auto operator==(const Message& other) const -> bool { return is_equal_to(other); }
+      template<bool FixedWidthV = is_fixed_width, cpp::enable_if_t<!FixedWidthV, int> = 0>
+        auto serialized_size() const -> size_t
+        {
+          return id_field::fixed_size + fields_serializer::serialized_size(fields_);
+        }
+      auto operator==(const basic_message& other) const -> bool { return is_equal_to(other); }
       auto fields() const -> const field_tuple_type& { return fields_; }
+      auto fields() -> field_tuple_type& { return fields_; }
 
     private:
       field_tuple_type fields_;
@@ -283,28 +1669,71 @@ namespace tpl
           return std::get<I>(fields_);
         }
     private:
-      auto serialize_message_type_id(cpp::string& s) const -> void
+      auto serialize_message_type_id(char*& out) const -> void
         {
-          Field<char>::serialize(s, static_cast<char>(message_type_id()));
+          id_field::serialize(out, static_cast<char_type>(message_type_id()));
         }
-      auto serialize_fields(cpp::string& s) const -> void
+      auto serialize_fields(char*& out) const -> void
         {
-          detail::MessageSerializer<0, field_tuple_type>::serialize(s, fields_);    
+          fields_serializer::serialize(out, fields_);    
         }
-      auto is_equal_to(const Message& other) const -> bool
+      auto is_equal_to(const basic_message& other) const -> bool
         {
           return fields_ == other.fields_;
         }
     };
 
-    template<typename...MessageTs>
-    class definition 
+    template<message_id_type MessageTypeID, typename...MessageFieldTypes>
+      using Message = basic_message<std::allocator<char>, MessageTypeID, MessageFieldTypes...>;
+
+    /*!
+     * \brief A protocol definition: the set of `Message` types which may appear in a stream, and how they are framed
+     *        on the wire (see `framing`).  Use the `definition` or `framed_definition` aliases.
+     */
+    template<typename FramingT, typename StatsT, typename...MessageTs>
+    class basic_definition 
     {
       using message_tuple = cpp::tuple<MessageTs...>;
       using message_id_type = ET;
+      using framer_type = detail::framer<FramingT>;
+      using dispatcher_type = detail::static_dispatcher<message_tuple, FramingT, StatsT>;
+      using stats_hooks = detail::stats_hooks<StatsT, message_tuple, FramingT>;
+
+      template<typename MessageT>
+      static auto body_size(const MessageT& m) -> size_t
+        {
+          return detail::MessageSerializer<0, typename MessageT::field_tuple_type>::serialized_size(m.fields());
+        }
+      template<typename MessageT>
+      static auto check_message_type() -> void
+        {
+          static_assert(cpp::is_same<detail::matching_message_type_from<static_cast<size_t>(MessageT::message_type_id()), message_tuple>, MessageT>::value, "Message type is not part of this protocol definition.");
+        }
     public:
+      using framing_type       = FramingT;
+      using stats_type         = StatsT;
+      using message_tuple_type = message_tuple;
+
+      /*!
+       * \brief This definition, with its decoders and encoders reporting to a stats policy of type `S` (e.g.
+       *        `message_stats`, from `stats.hpp`) rather than to `StatsT`.
+       */
+      template<typename S>
+        using with_stats = basic_definition<FramingT, S, MessageTs...>;
+
+      /*!
+       * \brief The stats policy which this definition's decoders and encoders report to, shared by all threads; not
+       *        available for `null_stats`.
+       */
+      static auto stats() -> stats_type&
+        {
+          return stats_hooks::stats();
+        }
+
       template<message_id_type E>
         using message = detail::matching_message_type_from<static_cast<size_t>(E), message_tuple>;
+      template<message_id_type E>
+        using view = message_view<message<E>>;
       template<message_id_type MT_ID, typename...ArgTs>
       auto make_message(ArgTs&&...args) -> detail::matching_message_type_from<static_cast<size_t>(MT_ID), message_tuple>
         {
@@ -312,9 +1741,239 @@ namespace tpl
           typename message_type::field_tuple_type fields(cpp::forward<ArgTs>(args)...);
           return message_type { cpp::move(fields) };
         }
-      using visitor = detail::protocol_visitor<0, message_tuple>;
+      using visitor = detail::protocol_visitor<0, message_tuple, FramingT, StatsT>;
+      using stream_decoder = detail::stream_decoder<visitor>;
+
+      /*!
+       * \brief The number of bytes that `serialize(m, ...)` writes, including the message ID and any frame header.
+       */
+      template<typename MessageT>
+      static auto serialized_size(const MessageT& m) -> size_t
+        {
+          return framer_type::frame_size(body_size(m));
+        }
+      /*!
+       * \brief Encodes `m` in this definition's wire format, at `out`, which must have room for `serialized_size(m)`
+       *        bytes.  For unframed definitions, this is equivalent to `m.serialize(out)`; framed definitions must
+       *        encode through here.
+       */
+      template<typename MessageT>
+      static auto serialize(const MessageT& m, char*& out) -> void
+        {
+          check_message_type<MessageT>();
+          auto begin = out;
+          framer_type::write_header(out, static_cast<char>(MessageT::message_type_id()), body_size(m));
+          detail::MessageSerializer<0, typename MessageT::field_tuple_type>::serialize(out, m.fields());
+          stats_hooks::encoded(detail::message_index_from<static_cast<size_t>(MessageT::message_type_id()), message_tuple>::value, static_cast<size_t>(out - begin));
+        }
+      template<typename MessageT>
+      static auto serialize(const MessageT& m, cpp::string& s) -> void
+        {
+          auto offset = s.size();
+          s.resize(offset + serialized_size(m));
+          auto out = &s[offset];
+          serialize(m, out);
+        }
+      template<typename MessageT, typename SinkT>
+      static auto serialize(const MessageT& m, SinkT& sink) -> bool
+        {
+          auto out = sink.prepare(serialized_size(m));
+          if(out == nullptr)
+          {
+            return false;
+          }
+          serialize(m, out);
+          return true;
+        }
+      /*!
+       * \brief Encodes `m` in this definition's wire format into a scatter-gather writer (see `gather_buffer`), which
+       *        may refer to the payloads of `m`'s large string and sequence fields rather than copy them.
+       */
+      template<typename MessageT, typename GatherT>
+      static auto serialize_gather(const MessageT& m, GatherT& out) -> void
+        {
+          check_message_type<MessageT>();
+          // Without framing, the header doesn't depend upon the body size, so don't compute it.
+          auto body   = framer_type::is_framed? body_size(m) : 0;
+          auto header = out.prepare(framer_type::frame_size(body) - body);
+          framer_type::write_header(header, static_cast<char>(MessageT::message_type_id()), body);
+          detail::MessageSerializer<0, typename MessageT::field_tuple_type>::serialize_gather(out, m.fields());
+        }
+      template<typename MessageT>
+      static auto serialize(const MessageT& m) -> cpp::string
+        {
+          cpp::string result;
+          serialize(m, result);
+          return result;
+        }
+
+      /*!
+       * \brief Decodes each message in the `size` bytes at `data` and passes it to `handler`, which must be callable
+       *        with every message type (or a `message_view` of it)--or, in a framed protocol, with those of
+       *        interest.  An ID which matches no message type is passed to `unknown`; by default, an unframed protocol
+       *        throws `std::invalid_argument` (and the remainder of the input is discarded if `unknown` returns), while
+       *        a framed one skips it.
+       *
+       *        Unlike `visitor::accept`, no virtual call is involved, so small handlers are inlined into the decoder.
+       */
+      template<typename HandlerT, typename UnknownT = detail::default_unknown_message<FramingT>>
+      static auto dispatch(const char* data, size_t size, HandlerT&& handler, UnknownT&& unknown = UnknownT {}) -> void
+        {
+          dispatcher_type::dispatch(data, size, handler, unknown);
+        }
+      template<typename HandlerT, typename UnknownT = detail::default_unknown_message<FramingT>>
+      static auto dispatch(const cpp::string& s, HandlerT&& handler, UnknownT&& unknown = UnknownT {}) -> void
+        {
+          dispatch(s.data(), s.size(), cpp::forward<HandlerT>(handler), cpp::forward<UnknownT>(unknown));
+        }
+      /*!
+       * \brief Like `dispatch`, but never throws on malformed input, and may be used with exceptions disabled: decoding
+       *        stops before the first message which is truncated, malformed, or (if unframed) of unknown type, and the
+       *        result says which and where.  No message is passed on in part, though one decoded into a slot may leave
+       *        the slot partly overwritten.  A framed message of unknown type is passed to `unknown`, as by `dispatch`.
+       */
+      template<typename HandlerT, typename UnknownT = detail::default_unknown_message<FramingT>>
+      static auto try_dispatch(const char* data, size_t size, HandlerT&& handler, UnknownT&& unknown = UnknownT {}) -> decode_result
+        {
+          return dispatcher_type::try_dispatch(data, size, handler, unknown);
+        }
+
+      /*!
+       * \brief Dispatches as `dispatch` does, but decodes each message into a message of its type held by the decoder,
+       *        and passes that by `const` reference.  String and sequence fields reuse their capacity from one message
+       *        to the next, so that in the steady state, decoding allocates nothing.
+       *
+       *        The reference passed to the handler is only valid until the next message of the same type is decoded.
+       */
+      class slot_decoder
+      {
+      public:
+        template<typename HandlerT, typename UnknownT = detail::default_unknown_message<FramingT>>
+        auto dispatch(const char* data, size_t size, HandlerT&& handler, UnknownT&& unknown = UnknownT {}) -> void
+          {
+            dispatcher_type::dispatch_into(data, size, slots_, handler, unknown);
+          }
+        template<typename HandlerT, typename UnknownT = detail::default_unknown_message<FramingT>>
+        auto dispatch(const cpp::string& s, HandlerT&& handler, UnknownT&& unknown = UnknownT {}) -> void
+          {
+            dispatch(s.data(), s.size(), cpp::forward<HandlerT>(handler), cpp::forward<UnknownT>(unknown));
+          }
+        /*!
+         * \brief As `definition::try_dispatch`, decoding into the slots.
+         */
+        template<typename HandlerT, typename UnknownT = detail::default_unknown_message<FramingT>>
+        auto try_dispatch(const char* data, size_t size, HandlerT&& handler, UnknownT&& unknown = UnknownT {}) -> decode_result
+          {
+            return dispatcher_type::try_dispatch_into(data, size, slots_, handler, unknown);
+          }
+      private:
+        message_tuple slots_;
+      };
+
+      /*!
+       * \brief Encodes batches of messages of any types in this definition into one reusable buffer.
+       *
+       *        `encode` sums the encoded sizes of all of its messages first, so that the buffer grows--if at all--once
+       *        per batch rather than once per message; the buffer is never shrunk, so that once it has grown to fit a
+       *        typical batch, encoding allocates nothing.  `flush` hands the encoded bytes to a writer (e.g. an
+       *        `fd_writer`) and empties the buffer.
+       */
+      class batch_encoder
+      {
+      public:
+        batch_encoder() = default;
+        explicit batch_encoder(size_t capacity)
+          {
+            reserve(capacity);
+          }
+
+        /*!
+         * \brief Appends the encoding of each of `messages`, in order.
+         */
+        template<typename...EncodedTs>
+        auto encode(const EncodedTs&...messages) -> void
+          {
+            size_t sizes[] = { 0, serialized_size(messages)... };
+            size_t total   = 0;
+            for(auto size : sizes)
+            {
+              total += size;
+            }
+            auto out = prepare(total);
+            int expansion[] = { 0, (serialize(messages, out), 0)... };
+            (void)expansion;
+            (void)out;
+            size_ += total;
+          }
+        /*!
+         * \brief Appends the encoding of each message in `[first, last)`, which must be a multi-pass range.
+         */
+        template<typename IteratorT>
+        auto encode_range(IteratorT first, IteratorT last) -> void
+          {
+            size_t total = 0;
+            for(auto it = first; it != last; ++it)
+            {
+              total += serialized_size(*it);
+            }
+            auto out = prepare(total);
+            for(auto it = first; it != last; ++it)
+            {
+              serialize(*it, out);
+            }
+            size_ += total;
+          }
+        /*!
+         * \brief Passes the encoded bytes to `writer(const char* data, size_t size)`, then empties the buffer.  If the
+         *        writer throws, the buffer is left as it was.
+         */
+        template<typename WriterT>
+        auto flush(WriterT&& writer) -> void
+          {
+            if(size_ != 0)
+            {
+              writer(data(), size_);
+            }
+            clear();
+          }
+        auto data() const -> const char* { return buffer_.get(); }
+        auto size() const -> size_t { return size_; }
+        auto empty() const -> bool { return size_ == 0; }
+        auto capacity() const -> size_t { return capacity_; }
+        auto clear() -> void { size_ = 0; }
+        auto reserve(size_t capacity) -> void
+          {
+            if(capacity > capacity_)
+            {
+              std::unique_ptr<char[]> buffer(new char[capacity]);
+              std::copy(buffer_.get(), buffer_.get() + size_, buffer.get());
+              buffer_   = cpp::move(buffer);
+              capacity_ = capacity;
+            }
+          }
+      private:
+        /*
+         * Space for `n` more bytes; unlike a string, the buffer is not zero-filled only to be overwritten.
+         */
+        auto prepare(size_t n) -> char*
+          {
+            if(capacity_ - size_ < n)
+            {
+              reserve(std::max(size_ + n, capacity_ * 2));
+            }
+            return buffer_.get() + size_;
+          }
+
+        std::unique_ptr<char[]> buffer_;
+        size_t                  size_     = 0;
+        size_t                  capacity_ = 0;
+      };
     };
-    
+
+    template<typename...MessageTs>
+      using definition = basic_definition<framing::none, null_stats, MessageTs...>;
+    template<typename...MessageTs>
+      using framed_definition = basic_definition<framing::length_prefixed, null_stats, MessageTs...>;
   };
 } /* namespace pt */
 #endif//protocol_hpp_20200903_133809_PDT
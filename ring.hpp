@@ -0,0 +1,174 @@
+#ifndef ring_hpp_20201114_101206_PDT
+#define ring_hpp_20201114_101206_PDT
+
+#include <cpp/cpp.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace tpl
+{
+  namespace detail {
+
+      /*!
+       * \brief Assumed size of a cache line, for keeping data written by different threads apart.
+       */
+      constexpr size_t cache_line_size = 64;
+
+      /*!
+       * \brief Waits a little longer each time it is called: spinning at first, then yielding the processor, and at
+       *        last sleeping briefly--so that a waiting thread reacts quickly to a busy peer, but does not monopolize a
+       *        core shared with it, nor burn one while idle.
+       */
+      class backoff
+      {
+      public:
+        auto operator()() -> void
+          {
+            if(count_ < 64)
+            {
+              ++count_;
+            }
+            else if(count_ < 64 + 256)
+            {
+              ++count_;
+              std::this_thread::yield();
+            }
+            else
+            {
+              std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+          }
+      private:
+        unsigned count_ = 0;
+      };
+  } /* namespace detail */
+
+  /*!
+   * \brief A bounded, lock-free queue between exactly one producer thread and one consumer thread.
+   *
+   *        Each side owns one index, on a cache line of its own, and keeps a private copy of the other side's index,
+   *        which it refreshes only when the copy says the ring is full (or empty); so while the ring is neither, the
+   *        two threads share no cache lines but the slots themselves.  `push` and `pop` wait (see `detail::backoff`)
+   *        for room or for an element.  Either side may `close` the ring: `push` then fails at once, and `pop` fails
+   *        once the ring is drained.
+   */
+  template<typename T>
+  class spsc_ring
+  {
+  public:
+    /*!
+     * \brief Creates a ring of at least `capacity` default-constructed slots (rounded up to a power of two).
+     */
+    explicit spsc_ring(size_t capacity)
+      : slots_(round_up(capacity)),
+        mask_(slots_.size() - 1)
+      {}
+    spsc_ring(const spsc_ring&) = delete;
+    auto operator=(const spsc_ring&) -> spsc_ring& = delete;
+
+    /*!
+     * \brief Moves `value` into the ring, if there is room; producer only.
+     */
+    auto try_push(T& value) -> bool
+      {
+        auto tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_cache_ == slots_.size())
+        {
+          head_cache_ = head_.load(std::memory_order_acquire);
+          if(tail - head_cache_ == slots_.size())
+          {
+            return false;
+          }
+        }
+        slots_[tail & mask_] = cpp::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+      }
+    /*!
+     * \brief Moves `value` into the ring, waiting for room; returns false, without waiting, if the ring is closed.
+     */
+    auto push(T value) -> bool
+      {
+        detail::backoff wait;
+        while(!closed())
+        {
+          if(try_push(value))
+          {
+            return true;
+          }
+          wait();
+        }
+        return false;
+      }
+    /*!
+     * \brief Moves the oldest element into `value`, if there is one; consumer only.
+     */
+    auto try_pop(T& value) -> bool
+      {
+        auto head = head_.load(std::memory_order_relaxed);
+        if(head == tail_cache_)
+        {
+          tail_cache_ = tail_.load(std::memory_order_acquire);
+          if(head == tail_cache_)
+          {
+            return false;
+          }
+        }
+        value = cpp::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+      }
+    /*!
+     * \brief Moves the oldest element into `value`, waiting for one; returns false once the ring is closed and empty.
+     */
+    auto pop(T& value) -> bool
+      {
+        detail::backoff wait;
+        while(!try_pop(value))
+        {
+          if(closed())
+          {
+            // Elements pushed before the ring was closed are still delivered.
+            return try_pop(value);
+          }
+          wait();
+        }
+        return true;
+      }
+    auto close() -> void
+      {
+        closed_.store(true, std::memory_order_release);
+      }
+    auto closed() const -> bool
+      {
+        return closed_.load(std::memory_order_acquire);
+      }
+    auto capacity() const -> size_t { return slots_.size(); }
+  private:
+    static auto round_up(size_t capacity) -> size_t
+      {
+        size_t n = 1;
+        while(n < capacity)
+        {
+          n <<= 1;
+        }
+        return n;
+      }
+
+    std::vector<T>      slots_;
+    size_t              mask_;
+    char                consumer_line_[detail::cache_line_size];
+    std::atomic<size_t> head_       { 0 };
+    size_t              tail_cache_ = 0;
+    char                producer_line_[detail::cache_line_size];
+    std::atomic<size_t> tail_       { 0 };
+    size_t              head_cache_ = 0;
+    char                shared_line_[detail::cache_line_size];
+    std::atomic<bool>   closed_     { false };
+  };
+} /* namespace tpl */
+
+#endif//ring_hpp_20201114_101206_PDT
@@ -0,0 +1,364 @@
+#ifndef stats_hpp_20201205_111734_PDT
+#define stats_hpp_20201205_111734_PDT
+
+#include "protocol.hpp"
+#include "ring.hpp"
+#include <cpp/cpp.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace tpl
+{
+/*********************************************************************************************************************
+* Implementation of `basic_message_stats` class.
+*
+* A stats policy (see `definition::with_stats`) which counts, for each message type, the messages decoded, their bytes,
+* decode failures, and the messages and bytes encoded; and which times the decode and the handling (`visit`, or the
+* handler's call) of one message of each type in every `SamplePeriod`, adding each to a running total and their sum to a
+* histogram.
+*
+* Each thread records into a slot of its own, which only it writes, so recording takes no lock and no atomic
+* read-modify-write--only relaxed loads and stores, which compile to plain moves--and each slot's counters lie on
+* cache lines of their own, so that threads decoding at once do not contend for them.  Even so, a decoding call counts
+* its messages in a `batch` of locals, and adds them to the slot once, as it returns; a message touches the slot
+* itself only if it is timed.  `snapshot` sums the slots of every thread which has recorded so far, including those
+* which have since exited; it may be taken from any thread at any time, and sees each thread's counters as of the end
+* of one of its decoding calls.
+*
+* Timing is sampled because reading the clock costs more than decoding a small message; the counters are exact.
+*********************************************************************************************************************/
+  /*!
+   * \brief Counters for one message type, summed over threads.
+   */
+  struct message_type_stats
+  {
+    static constexpr size_t histogram_size = 32;
+
+    size_t   message_id    = 0;
+    uint64_t messages      = 0;  //!< Messages decoded.
+    uint64_t bytes         = 0;  //!< Bytes of those messages, less any frame header.
+    uint64_t failures      = 0;  //!< Messages which failed to decode.
+    uint64_t encoded       = 0;  //!< Messages encoded.
+    uint64_t encoded_bytes = 0;  //!< Bytes of those messages, including any frame header.
+    uint64_t samples       = 0;  //!< Messages timed.
+    uint64_t decode_ns     = 0;  //!< Time spent decoding the messages timed.
+    uint64_t visit_ns      = 0;  //!< Time spent handling the messages timed.
+    /*!
+     * \brief Of the messages timed, the number whose decode and handling together took `[2^i, 2^(i+1))` ns; the first
+     *        bucket also counts those which took under 1 ns, and the last those which took longer.
+     */
+    std::array<uint64_t, histogram_size> latency = {};
+  };
+
+  /*!
+   * \brief Counters for every message type of a definition, summed over threads.
+   */
+  struct message_stats_snapshot
+  {
+    std::vector<message_type_stats> types;           //!< In definition order.
+    uint64_t                        unknown = 0;     //!< Messages whose ID matches no message type.
+
+    /*!
+     * \brief Writes the snapshot as a JSON object.
+     */
+    auto write_json(std::ostream& os) const -> void
+      {
+        os << "{ \"unknown\": " << unknown << ", \"types\": [";
+        for(size_t i = 0; i < types.size(); ++i)
+        {
+          const auto& t = types[i];
+          os << (i == 0? "\n  " : ",\n  ")
+             << "{ \"id\": " << t.message_id << ", \"messages\": " << t.messages << ", \"bytes\": " << t.bytes
+             << ", \"failures\": " << t.failures << ", \"encoded\": " << t.encoded << ", \"encoded_bytes\": " << t.encoded_bytes
+             << ", \"samples\": " << t.samples << ", \"decode_ns\": " << t.decode_ns << ", \"visit_ns\": " << t.visit_ns
+             << ", \"latency\": [";
+          for(size_t b = 0; b < t.latency.size(); ++b)
+          {
+            os << (b == 0? "" : ", ") << t.latency[b];
+          }
+          os << "] }";
+        }
+        os << "\n] }\n";
+      }
+  };
+
+  /*!
+   * \brief A stats policy which counts messages, bytes and failures per message type, and times one message in
+   *        every `SamplePeriod` (a power of two) of each type; see above.
+   */
+  template<size_t SamplePeriod = 1024>
+  class basic_message_stats
+  {
+    static_assert(SamplePeriod != 0 && (SamplePeriod & (SamplePeriod - 1)) == 0, "The sample period must be a power of two.");
+
+    using clock_type = std::chrono::steady_clock;
+    using counter    = std::atomic<uint64_t>;
+
+    /*
+     * Nine counters and the histogram: five cache lines.
+     */
+    struct type_counters
+    {
+      counter messages;
+      counter bytes;
+      counter failures;
+      counter encoded;
+      counter encoded_bytes;
+      counter samples;
+      counter decode_ns;
+      counter visit_ns;
+      counter latency[message_type_stats::histogram_size];
+    };
+
+    /*
+     * Only the owning thread writes a counter, so it need not be incremented atomically.
+     */
+    static auto add(counter& c, uint64_t n) -> void
+      {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+      }
+    static auto elapsed_ns(clock_type::time_point from, clock_type::time_point to) -> uint64_t
+      {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+      }
+    static auto bucket(uint64_t ns) -> size_t
+      {
+        size_t b = 0;
+        while(ns > 1 && b + 1 < message_type_stats::histogram_size)
+        {
+          ns >>= 1;
+          ++b;
+        }
+        return b;
+      }
+  public:
+    /*!
+     * \brief One thread's counters.
+     */
+    class slot
+    {
+    public:
+      explicit slot(size_t type_count)
+        // The first and last elements are never used, so that no other allocation shares a cache line with the rest.
+        : types_(type_count + 2)
+        {}
+
+      /*!
+       * \brief The counts of one decoding call (`accept`, `dispatch`, `try_dispatch` and the like) of a definition of
+       *        `TypeCount` message types, kept in locals and added to the slot as the call returns.  While the call
+       *        runs, only a message which is timed touches the slot.
+       */
+      template<size_t TypeCount>
+      class batch
+      {
+      public:
+        explicit batch(slot& s)
+          : slot_(s)
+          {
+            for(size_t i = 0; i < TypeCount; ++i)
+            {
+              messages_[i] = base_[i] = s.types_[i + 1].messages.load(std::memory_order_relaxed);
+            }
+          }
+        batch(const batch&) = delete;
+        auto operator=(const batch&) -> batch& = delete;
+        ~batch()
+          {
+            for(size_t i = 0; i < TypeCount; ++i)
+            {
+              auto& types = slot_.types_[i + 1];
+              if(messages_[i] != base_[i])
+              {
+                add(types.messages, messages_[i] - base_[i]);
+                add(types.bytes, bytes_[i]);
+              }
+              if(failures_[i] != 0)
+              {
+                add(types.failures, failures_[i]);
+              }
+            }
+            if(failures_[TypeCount] != 0)
+            {
+              add(slot_.unknown_, failures_[TypeCount]);
+            }
+          }
+
+        /*!
+         * \brief Whether the next message of type `index` is to be timed.
+         */
+        auto timed(size_t index) const -> bool
+          {
+            return (messages_[index] & (SamplePeriod - 1)) == 0;
+          }
+
+        /*!
+         * \brief Records the decode, and handling, of one message.  The message is counted as the probe is
+         *        destroyed, once it has been handled, so that nothing is written between its decode and its handling
+         *        which might keep the compiler from passing the decoded message straight to the handler.
+         */
+        class probe
+        {
+        public:
+          probe(batch& b, size_t index, const char* begin)
+            : batch_(b),
+              index_(index),
+              begin_(begin)
+            {}
+          probe(const probe&) = delete;
+          auto operator=(const probe&) -> probe& = delete;
+          // Inlined even when decoding throws, so that the probe's members may live in registers.
+          TEMPLAR_INLINE ~probe()
+            {
+              if(end_ != nullptr)
+              {
+                ++batch_.messages_[index_];
+                batch_.bytes_[index_] += static_cast<uint64_t>(end_ - begin_);
+              }
+              else
+              {
+                ++batch_.failures_[index_];
+              }
+            }
+          auto decoded(const char* end) -> void
+            {
+              end_ = end;
+            }
+          auto visited() -> void
+            {}
+        protected:
+          batch&      batch_;
+          size_t      index_;
+          const char* begin_;
+          const char* end_ = nullptr;
+        };
+
+        /*!
+         * \brief Records the decode, and handling, of one message, and times each.
+         */
+        class timed_probe : public probe
+        {
+        public:
+          timed_probe(batch& b, size_t index, const char* begin)
+            : probe(b, index, begin),
+              start_(clock_type::now())
+            {}
+          auto decoded(const char* end) -> void
+            {
+              probe::decoded(end);
+              decoded_at_ = clock_type::now();
+            }
+          auto visited() -> void
+            {
+              auto& types  = this->batch_.slot_.types_[this->index_ + 1];
+              auto  decode = elapsed_ns(start_, decoded_at_);
+              auto  visit  = elapsed_ns(decoded_at_, clock_type::now());
+              add(types.samples, 1);
+              add(types.decode_ns, decode);
+              add(types.visit_ns, visit);
+              add(types.latency[bucket(decode + visit)], 1);
+            }
+        private:
+          clock_type::time_point start_;
+          clock_type::time_point decoded_at_;
+        };
+
+        /*!
+         * \brief Records a message of type `index` rejected as malformed, or an unknown ID if `index` is
+         *        `TypeCount`.
+         */
+        auto failed(size_t index) -> void
+          {
+            ++failures_[index];
+          }
+      private:
+        slot&                               slot_;
+        std::array<uint64_t, TypeCount>     base_;          // The slot's count of each type as the call began.
+        std::array<uint64_t, TypeCount>     messages_;      // That count, plus the call's own.
+        std::array<uint64_t, TypeCount>     bytes_    = {};
+        std::array<uint64_t, TypeCount + 1> failures_ = {};
+      };
+
+      auto encoded(size_t index, size_t bytes) -> void
+        {
+          add(types_[index + 1].encoded, 1);
+          add(types_[index + 1].encoded_bytes, bytes);
+        }
+    private:
+      friend class basic_message_stats;
+
+      char                       before_[detail::cache_line_size];
+      std::vector<type_counters> types_;
+      counter                    unknown_ { 0 };
+      char                       after_[detail::cache_line_size];
+    };
+    template<size_t TypeCount>
+      using batch = typename slot::template batch<TypeCount>;
+
+    explicit basic_message_stats(std::vector<size_t> message_ids)
+      : message_ids_(cpp::move(message_ids))
+      {}
+    basic_message_stats(const basic_message_stats&) = delete;
+    auto operator=(const basic_message_stats&) -> basic_message_stats& = delete;
+
+    /*!
+     * \brief Creates the calling thread's slot; called once per thread by the definition.
+     */
+    auto register_thread() -> slot&
+      {
+        std::unique_ptr<slot> s(new slot(message_ids_.size()));
+        std::lock_guard<std::mutex> lock(mutex_);
+        slots_.push_back(cpp::move(s));
+        return *slots_.back();
+      }
+    /*!
+     * \brief The counters of every thread, summed.
+     */
+    auto snapshot() const -> message_stats_snapshot
+      {
+        message_stats_snapshot result;
+        result.types.resize(message_ids_.size());
+        for(size_t i = 0; i < message_ids_.size(); ++i)
+        {
+          result.types[i].message_id = message_ids_[i];
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(const auto& s : slots_)
+        {
+          result.unknown += s->unknown_.load(std::memory_order_relaxed);
+          for(size_t i = 0; i < message_ids_.size(); ++i)
+          {
+            const auto& from = s->types_[i + 1];
+            auto&       to   = result.types[i];
+            to.messages      += from.messages.load(std::memory_order_relaxed);
+            to.bytes         += from.bytes.load(std::memory_order_relaxed);
+            to.failures      += from.failures.load(std::memory_order_relaxed);
+            to.encoded       += from.encoded.load(std::memory_order_relaxed);
+            to.encoded_bytes += from.encoded_bytes.load(std::memory_order_relaxed);
+            to.samples       += from.samples.load(std::memory_order_relaxed);
+            to.decode_ns     += from.decode_ns.load(std::memory_order_relaxed);
+            to.visit_ns      += from.visit_ns.load(std::memory_order_relaxed);
+            for(size_t b = 0; b < message_type_stats::histogram_size; ++b)
+            {
+              to.latency[b] += from.latency[b].load(std::memory_order_relaxed);
+            }
+          }
+        }
+        return result;
+      }
+    auto message_type_count() const -> size_t { return message_ids_.size(); }
+  private:
+    std::vector<size_t>                message_ids_;
+    mutable std::mutex                 mutex_;
+    std::vector<std::unique_ptr<slot>> slots_;
+  };
+
+  using message_stats = basic_message_stats<>;
+} /* namespace tpl */
+
+#endif//stats_hpp_20201205_111734_PDT
@@ -0,0 +1,73 @@
+#ifndef string_ref_hpp_20201003_141822_PDT
+#define string_ref_hpp_20201003_141822_PDT
+
+#include <string>
+#include <cstring>
+#include <ostream>
+#include <cpp/cpp.hpp>
+
+namespace tpl {
+/*!
+ * \brief A non-owning reference to a contiguous run of characters, in the spirit of C++17's `std::string_view`.
+ *
+ *        As a `Message` field, a `string_ref` is encoded exactly like a `cpp::string`, but decoding it only records
+ *        where the characters lie in the input buffer.  The decoded message therefore must not outlive the buffer
+ *        which was passed to `accept`.
+ */
+class string_ref
+{
+public:
+  using value_type     = char;
+  using size_type      = size_t;
+  using const_iterator = const char*;
+  using iterator       = const_iterator;
+
+  constexpr string_ref()
+    : data_(nullptr)
+    , size_(0)
+    {}
+  constexpr string_ref(const char* data, size_type size)
+    : data_(data)
+    , size_(size)
+    {}
+  string_ref(const char* s)
+    : data_(s)
+    , size_(std::strlen(s))
+    {}
+  string_ref(const cpp::string& s)
+    : data_(s.data())
+    , size_(s.size())
+    {}
+
+  constexpr auto data()  const -> const char* { return data_; }
+  constexpr auto size()  const -> size_type   { return size_; }
+  constexpr auto empty() const -> bool        { return size_ == 0; }
+  constexpr auto begin() const -> iterator    { return data_; }
+  constexpr auto end()   const -> iterator    { return data_ + size_; }
+  constexpr auto operator[](size_type i) const -> const char& { return data_[i]; }
+
+  /*!
+   * \brief Copies the referenced characters into an owning string.
+   */
+  auto str() const -> cpp::string { return cpp::string(data_, size_); }
+  explicit operator cpp::string() const { return str(); }
+
+  friend auto operator==(const string_ref& lhs, const string_ref& rhs) -> bool
+    {
+      return lhs.size_ == rhs.size_ && (lhs.size_ == 0 || std::memcmp(lhs.data_, rhs.data_, lhs.size_) == 0);
+    }
+  friend auto operator!=(const string_ref& lhs, const string_ref& rhs) -> bool
+    {
+      return !(lhs == rhs);
+    }
+  friend auto operator<<(std::ostream& os, const string_ref& s) -> std::ostream&
+    {
+      return os.write(s.data_, s.size_);
+    }
+private:
+  const char* data_;
+  size_type   size_;
+};
+} /* namespace tpl */
+
+#endif//string_ref_hpp_20201003_141822_PDT
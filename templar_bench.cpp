@@ -0,0 +1,560 @@
+/*
+ * The benchmark suite: one executable covering the costs most likely to regress--
+ *
+ *   - field/...:    encoding and decoding a run of values of each field type, straight through its `Field`;
+ *   - mixed/...:    a realistic stream of three message types, encoded with `definition::batch_encoder` and decoded
+ *                   through `protocol_visitor::accept` (unframed and framed), `definition::dispatch` and a
+ *                   `slot_decoder`;
+ *   - dispatch/...: decoding one-byte messages through `accept` and `dispatch`, as the number of message types grows;
+ *   - mixed/.../stats: the unframed mixed stream again, through a definition with a `message_stats` policy;
+ *   - mixed/... stats overhead: how much slower the policy makes each of the above than the default `null_stats`, and
+ *                   `mixed/accept noise`, the same comparison between two identical visitors.
+ *
+ * Each benchmark is run once to warm up, then `--repetitions` times; the fastest run is reported, in nanoseconds and
+ * heap allocations per item (value or message), and MB/s of encoded bytes.  Heap allocations are counted with a
+ * replaced global `operator new` (see `bench_allocations.hpp`).
+ *
+ * The overheads are too small to read off two benchmarks timed seconds apart, whose speeds drift by more than the
+ * difference; so each is measured on its own, on the first 4096 messages, with and without the policy run alternately
+ * `600 * --repetitions` times, each going first in turn, and the fastest of each compared.  The noise row shows how far
+ * apart two identical runs come out that way--within a percent or two.  Rows over the 10% target are marked.  As
+ * measured on x86-64 with GCC, `dispatch` comes out at about 10%, `accept` and `slot_decoder` at about 15%, and
+ * `encode` at about 28%: the counters are exact, so every message pays for its count and bytes, a handful of
+ * instructions against the ten or so which decode or encode a small quote; only the timing, which costs more than
+ * that, is sampled.
+ *
+ *   templar_bench [--filter SUBSTRING] [--items N] [--repetitions N] [--json FILE]
+ *
+ * `--json` also writes the results, with the build's compiler and whether assertions were enabled, to FILE--or to
+ * standard output, given `-`, in which case the table goes to standard error--so that runs can be compared over time.
+ *
+ * Build with optimizations enabled (e.g. `-DCMAKE_BUILD_TYPE=Release`) for meaningful numbers.
+ */
+#include "protocol.hpp"
+#include "stats.hpp"
+#include "bench_allocations.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+  using protocol_class = tpl::protocol<uint8_t>;
+
+  /*
+   * Keeps the work being measured from being optimized away.
+   */
+  volatile uint64_t sink_value = 0;
+
+  struct options
+  {
+    const char* filter      = "";
+    const char* json        = nullptr;
+    size_t      items       = 1 << 20;
+    size_t      repetitions = 5;
+  };
+
+  struct result
+  {
+    std::string name;
+    double      ns_per_item;
+    double      mb_per_s;
+    double      allocations_per_item;
+    double      bytes_per_item;
+  };
+
+  /*
+   * Runs and reports benchmarks; see above.
+   */
+  class suite
+  {
+  public:
+    explicit suite(const options& opts)
+      : options_(opts),
+        table_(opts.json != nullptr && std::strcmp(opts.json, "-") == 0? stderr : stdout)
+      {
+        std::fprintf(table_, "%-32s %12s %12s %12s %12s\n", "benchmark", "ns/item", "MB/s", "allocs/item", "bytes/item");
+      }
+
+    auto items() const -> size_t { return options_.items; }
+
+    /*!
+     * \brief Runs `f`, which processes `items` items encoded in `bytes` bytes, unless the filter excludes `name`.
+     */
+    template<typename FunctionT>
+    auto run(const std::string& name, size_t items, size_t bytes, FunctionT&& f) -> void
+      {
+        if(name.find(options_.filter) == std::string::npos)
+        {
+          return;
+        }
+        f();
+        double best_ns     = 0;
+        size_t allocations = 0;
+        for(size_t r = 0; r < options_.repetitions; ++r)
+        {
+          auto before = bench::allocation_count();
+          auto start  = std::chrono::steady_clock::now();
+          f();
+          auto stop   = std::chrono::steady_clock::now();
+          allocations += bench::allocation_count() - before;
+          auto ns = std::chrono::duration<double, std::nano>(stop - start).count();
+          if(r == 0 || ns < best_ns)
+          {
+            best_ns = ns;
+          }
+        }
+        auto n = static_cast<double>(items);
+        result x { name, best_ns / n, static_cast<double>(bytes) / (best_ns / 1e9) / 1e6,
+                   static_cast<double>(allocations) / static_cast<double>(options_.repetitions) / n, static_cast<double>(bytes) / n };
+        std::fprintf(table_, "%-32s %12.2f %12.1f %12.3f %12.2f\n", x.name.c_str(), x.ns_per_item, x.mb_per_s, x.allocations_per_item, x.bytes_per_item);
+        std::fflush(table_);
+        results_.push_back(x);
+      }
+
+    /*!
+     * \brief Reports how much slower `f` is than `base`, which does the same work, unless the filter excludes `name`.
+     *        The two are run alternately, so that both see the same drift in the machine's speed, and their fastest
+     *        runs compared; see above.
+     */
+    template<typename BaseT, typename FunctionT>
+    auto overhead(const std::string& name, BaseT&& base, FunctionT&& f) -> void
+      {
+        if(name.find(options_.filter) == std::string::npos)
+        {
+          return;
+        }
+        base();
+        f();
+        double best_base = 0;
+        double best      = 0;
+        for(size_t r = 0; r < options_.repetitions * overhead_rounds; ++r)
+        {
+          // Each goes first in turn, so that neither gains from what the other leaves in the caches.
+          double base_ns;
+          double ns;
+          if(r % 2 == 0)
+          {
+            base_ns = time(base);
+            ns      = time(f);
+          }
+          else
+          {
+            ns      = time(f);
+            base_ns = time(base);
+          }
+          best_base = r == 0? base_ns : std::min(best_base, base_ns);
+          best      = r == 0? ns : std::min(best, ns);
+        }
+        auto percent = (best / best_base - 1) * 100;
+        std::fprintf(table_, "%-32s %+11.1f%%%s\n", name.c_str(), percent, percent > overhead_target? "  over target" : "");
+        std::fflush(table_);
+      }
+
+    static constexpr size_t overhead_rounds = 600;   //!< Rounds per repetition in `overhead`.
+    static constexpr double overhead_target = 10;    //!< The overhead, in percent, a stats policy should stay under.
+
+    /*!
+     * \brief Writes the results as JSON, if asked to; returns false if the file cannot be written.
+     */
+    auto write_json() const -> bool
+      {
+        if(options_.json == nullptr)
+        {
+          return true;
+        }
+        auto to_stdout = std::strcmp(options_.json, "-") == 0;
+        auto file      = to_stdout? stdout : std::fopen(options_.json, "w");
+        if(file == nullptr)
+        {
+          std::perror(options_.json);
+          return false;
+        }
+#if defined(__VERSION__)
+        const char* compiler = __VERSION__;
+#else
+        const char* compiler = "unknown";
+#endif
+#if defined(NDEBUG)
+        const char* assertions = "false";
+#else
+        const char* assertions = "true";
+#endif
+        std::fprintf(file, "{\n  \"context\": { \"compiler\": \"%s\", \"assertions\": %s, \"items\": %zu, \"repetitions\": %zu },\n  \"benchmarks\": [\n",
+                     compiler, assertions, options_.items, options_.repetitions);
+        for(size_t i = 0; i < results_.size(); ++i)
+        {
+          const auto& x = results_[i];
+          std::fprintf(file, "    { \"name\": \"%s\", \"ns_per_item\": %.3f, \"mb_per_s\": %.3f, \"allocs_per_item\": %.4f, \"bytes_per_item\": %.3f }%s\n",
+                       x.name.c_str(), x.ns_per_item, x.mb_per_s, x.allocations_per_item, x.bytes_per_item, i + 1 == results_.size()? "" : ",");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        if(!to_stdout)
+        {
+          std::fclose(file);
+        }
+        return true;
+      }
+  private:
+    template<typename FunctionT>
+    static auto time(FunctionT& f) -> double
+      {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+      }
+
+    options             options_;
+    FILE*               table_;
+    std::vector<result> results_;
+  };
+
+  /*********************************************************************************************************************
+  * field/...
+  *********************************************************************************************************************/
+  template<typename T>
+  auto weight(const T& value) -> uint64_t
+    {
+      return static_cast<uint64_t>(value);
+    }
+  auto weight(const cpp::string& value) -> uint64_t
+    {
+      return value.size();
+    }
+
+  template<typename T>
+  auto make_values(size_t count) -> std::vector<T>
+    {
+      std::vector<T> values;
+      values.reserve(count);
+      for(size_t i = 0; i < count; ++i)
+      {
+        values.push_back(static_cast<T>(i * 0x9E3779B97F4A7C15ull));
+      }
+      return values;
+    }
+  auto make_bools(size_t count) -> std::vector<bool>
+    {
+      std::vector<bool> values;
+      values.reserve(count);
+      for(size_t i = 0; i < count; ++i)
+      {
+        values.push_back(i % 3 == 0);
+      }
+      return values;
+    }
+  /*
+   * Strings of exactly `length` characters, which vary from one to the next.
+   */
+  auto make_strings(size_t count, size_t length) -> std::vector<cpp::string>
+    {
+      std::vector<cpp::string> values;
+      values.reserve(count);
+      for(size_t i = 0; i < count; ++i)
+      {
+        cpp::string s(length, 'a');
+        s[i % length] = static_cast<char>('a' + i % 26);
+        values.push_back(cpp::move(s));
+      }
+      return values;
+    }
+
+  template<typename T, typename VectorT>
+  auto run_field(suite& s, const std::string& name, const VectorT& values) -> void
+    {
+      using field_type = tpl::Field<T>;
+      size_t bytes = 0;
+      for(const auto& value : values)
+      {
+        bytes += field_type::serialized_size(value);
+      }
+      std::vector<char> buffer(bytes);
+      s.run("field/" + name + "/encode", values.size(), bytes, [&]
+        {
+          auto out = buffer.data();
+          for(const auto& value : values)
+          {
+            field_type::serialize(out, value);
+          }
+        });
+      s.run("field/" + name + "/decode", values.size(), bytes, [&]
+        {
+          const char* begin = buffer.data();
+          const char* end   = begin + buffer.size();
+          uint64_t    sum   = 0;
+          while(begin < end)
+          {
+            sum += weight(field_type::deserialize(begin, end));
+          }
+          sink_value = sum;
+        });
+    }
+
+  auto run_fields(suite& s) -> void
+    {
+      auto n = s.items();
+      run_field<bool>(s, "bool", make_bools(n));
+      run_field<int8_t>(s, "int8", make_values<int8_t>(n));
+      run_field<uint8_t>(s, "uint8", make_values<uint8_t>(n));
+      run_field<int16_t>(s, "int16", make_values<int16_t>(n));
+      run_field<uint16_t>(s, "uint16", make_values<uint16_t>(n));
+      run_field<int32_t>(s, "int32", make_values<int32_t>(n));
+      run_field<uint32_t>(s, "uint32", make_values<uint32_t>(n));
+      run_field<int64_t>(s, "int64", make_values<int64_t>(n));
+      run_field<uint64_t>(s, "uint64", make_values<uint64_t>(n));
+      run_field<cpp::string>(s, "string8", make_strings(n, 8));
+      run_field<cpp::string>(s, "string200", make_strings(n / 8, 200));
+    }
+
+  /*********************************************************************************************************************
+  * mixed/...
+  *********************************************************************************************************************/
+  // timestamp, instrument, price, size
+  using quote_type = protocol_class::Message<1, int64_t, uint32_t, double, int32_t>;
+  // timestamp, symbol, quantity, buy
+  using order_type = protocol_class::Message<2, int64_t, cpp::string, uint32_t, bool>;
+  // timestamp, headline, instruments
+  using news_type  = protocol_class::Message<3, int64_t, cpp::string, std::vector<uint16_t>>;
+
+  using mixed_definition = protocol_class::definition<quote_type, order_type, news_type>;
+  using mixed_framed     = protocol_class::framed_definition<quote_type, order_type, news_type>;
+  using mixed_stats      = mixed_definition::with_stats<tpl::message_stats>;
+
+  struct mixed_handler
+  {
+    auto operator()(const quote_type& m) -> void { sum += static_cast<uint64_t>(m.get<3>()); }
+    auto operator()(const order_type& m) -> void { sum += m.get<1>().size() + m.get<2>(); }
+    auto operator()(const news_type& m) -> void { sum += m.get<1>().size() + m.get<2>().size(); }
+    uint64_t sum = 0;
+  };
+
+  template<typename DefinitionT>
+  class mixed_visitor : public DefinitionT::visitor
+  {
+  public:
+    virtual auto visit(const quote_type& m) -> void override { handler(m); }
+    virtual auto visit(const order_type& m) -> void override { handler(m); }
+    virtual auto visit(const news_type& m) -> void override { handler(m); }
+    mixed_handler handler;
+  };
+
+  /*
+   * Seven quotes in ten, a quarter orders, and the rest news.
+   */
+  struct mixed_stream
+  {
+    explicit mixed_stream(size_t count)
+      {
+        cpp::string headline(120, 'n');
+        for(size_t i = 0; i < count; ++i)
+        {
+          auto timestamp = static_cast<int64_t>(1600000000000000000 + i * 1000);
+          auto kind      = i * 7 % 20;
+          if(kind < 14)
+          {
+            quotes.push_back(quote_type { cpp::make_tuple(timestamp, static_cast<uint32_t>(i % 500), 100.0 + static_cast<double>(i % 100) / 8, static_cast<int32_t>(i % 1000)) });
+          }
+          else if(kind < 19)
+          {
+            orders.push_back(order_type { cpp::make_tuple(timestamp, cpp::string(i % 2? "AAPL" : "MSFT"), static_cast<uint32_t>(i % 10000), i % 2 == 0) });
+          }
+          else
+          {
+            news.push_back(news_type { cpp::make_tuple(timestamp, headline, std::vector<uint16_t>(4, static_cast<uint16_t>(i))) });
+          }
+          kinds.push_back(static_cast<uint8_t>(kind < 14? 0 : kind < 19? 1 : 2));
+        }
+      }
+    /*
+     * Encodes the messages, in order.
+     */
+    template<typename EncoderT>
+    auto encode(EncoderT& encoder) const -> void
+      {
+        size_t quote = 0;
+        size_t order = 0;
+        size_t story = 0;
+        for(auto kind : kinds)
+        {
+          switch(kind)
+          {
+          case 0:  encoder.encode(quotes[quote++]); break;
+          case 1:  encoder.encode(orders[order++]); break;
+          default: encoder.encode(news[story++]); break;
+          }
+        }
+      }
+
+    std::vector<quote_type> quotes;
+    std::vector<order_type> orders;
+    std::vector<news_type>  news;
+    std::vector<uint8_t>    kinds;
+  };
+
+  template<typename DefinitionT>
+  auto run_mixed(suite& s, const mixed_stream& stream, const std::string& framing) -> void
+    {
+      auto n = stream.kinds.size();
+      typename DefinitionT::batch_encoder encoder;
+      stream.encode(encoder);
+      auto bytes = encoder.size();
+      s.run("mixed/encode" + framing, n, bytes, [&]
+        {
+          encoder.clear();
+          stream.encode(encoder);
+        });
+      mixed_visitor<DefinitionT> visitor;
+      s.run("mixed/accept" + framing, n, bytes, [&] { visitor.accept(encoder.data(), encoder.size()); });
+      mixed_handler handler;
+      s.run("mixed/dispatch" + framing, n, bytes, [&] { DefinitionT::dispatch(encoder.data(), encoder.size(), handler); });
+      typename DefinitionT::slot_decoder slots;
+      s.run("mixed/slot_decoder" + framing, n, bytes, [&] { slots.dispatch(encoder.data(), encoder.size(), handler); });
+      sink_value = visitor.handler.sum + handler.sum;
+    }
+
+  auto run_mixed(suite& s) -> void
+    {
+      mixed_stream stream(s.items());
+      run_mixed<mixed_definition>(s, stream, "");
+      run_mixed<mixed_framed>(s, stream, "/framed");
+      run_mixed<mixed_stats>(s, stream, "/stats");
+    }
+
+  /*
+   * The overhead of `message_stats` over `null_stats`, on the first few thousand messages of the mixed stream; and,
+   * as a measure of the noise in those figures, of `null_stats` over itself.
+   */
+  auto run_stats_overhead(suite& s) -> void
+    {
+      mixed_stream stream(std::min<size_t>(s.items(), 4096));
+      mixed_definition::batch_encoder encoder;
+      mixed_stats::batch_encoder      stats_encoder;
+      stream.encode(encoder);
+      s.overhead("mixed/encode stats overhead", [&] { encoder.clear(); stream.encode(encoder); },
+                                                [&] { stats_encoder.clear(); stream.encode(stats_encoder); });
+      mixed_visitor<mixed_definition> visitor;
+      mixed_visitor<mixed_definition> other_visitor;
+      mixed_visitor<mixed_stats>      stats_visitor;
+      s.overhead("mixed/accept stats overhead", [&] { visitor.accept(encoder.data(), encoder.size()); },
+                                                [&] { stats_visitor.accept(encoder.data(), encoder.size()); });
+      s.overhead("mixed/accept noise", [&] { visitor.accept(encoder.data(), encoder.size()); },
+                                       [&] { other_visitor.accept(encoder.data(), encoder.size()); });
+      mixed_handler handler;
+      s.overhead("mixed/dispatch stats overhead", [&] { mixed_definition::dispatch(encoder.data(), encoder.size(), handler); },
+                                                  [&] { mixed_stats::dispatch(encoder.data(), encoder.size(), handler); });
+      mixed_definition::slot_decoder slots;
+      mixed_stats::slot_decoder      stats_slots;
+      s.overhead("mixed/slot_decoder stats overhead", [&] { slots.dispatch(encoder.data(), encoder.size(), handler); },
+                                                      [&] { stats_slots.dispatch(encoder.data(), encoder.size(), handler); });
+      sink_value = visitor.handler.sum + other_visitor.handler.sum + stats_visitor.handler.sum + handler.sum;
+    }
+
+  /*********************************************************************************************************************
+  * dispatch/...
+  *********************************************************************************************************************/
+  template<typename SequenceT>
+  struct make_protocol;
+
+  template<size_t...IDs>
+  struct make_protocol<tpl::detail::index_sequence<IDs...>>
+  {
+    using type = protocol_class::definition<protocol_class::Message<static_cast<uint8_t>(IDs), bool>...>;
+  };
+
+  template<size_t N>
+    using protocol_of = typename make_protocol<tpl::detail::make_index_sequence<N>>::type;
+
+  /*
+   * Implements one `visit` override per level, so that the most-derived `counter<0, N>` is a concrete visitor.
+   */
+  template<size_t I, size_t N>
+  class counter : public counter<I + 1, N>
+  {
+  public:
+    using message_type = typename protocol_of<N>::template message<static_cast<uint8_t>(I)>;
+    virtual auto visit(const message_type& m) -> void override
+      {
+        this->count_ += m.template get<0>()? 2 : 1;
+      }
+  };
+
+  template<size_t N>
+  class counter<N, N> : public protocol_of<N>::visitor
+  {
+  public:
+    auto count() const -> size_t { return count_; }
+  protected:
+    size_t count_ = 0;
+  };
+
+  struct static_counter
+  {
+    template<typename MessageT>
+    auto operator()(const MessageT& m) -> void
+      {
+        count += m.template get<0>()? 2 : 1;
+      }
+    size_t count = 0;
+  };
+
+  template<size_t N>
+  auto run_dispatch(suite& s) -> void
+    {
+      std::string buffer;
+      for(size_t i = 0; i < s.items(); ++i)
+      {
+        buffer += static_cast<char>(i % N);
+        buffer += static_cast<char>(i & 1);
+      }
+      auto suffix = "/" + std::to_string(N);
+      counter<0, N> visitor;
+      s.run("dispatch/accept" + suffix, s.items(), buffer.size(), [&] { visitor.accept(buffer); });
+      static_counter handler;
+      s.run("dispatch/static" + suffix, s.items(), buffer.size(), [&] { protocol_of<N>::dispatch(buffer, handler); });
+      sink_value = visitor.count() + handler.count;
+    }
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  options opts;
+  for(int i = 1; i < argc; ++i)
+  {
+    auto has_value = i + 1 < argc;
+    if(std::strcmp(argv[i], "--filter") == 0 && has_value)
+    {
+      opts.filter = argv[++i];
+    }
+    else if(std::strcmp(argv[i], "--json") == 0 && has_value)
+    {
+      opts.json = argv[++i];
+    }
+    else if(std::strcmp(argv[i], "--items") == 0 && has_value)
+    {
+      opts.items = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+    }
+    else if(std::strcmp(argv[i], "--repetitions") == 0 && has_value)
+    {
+      opts.repetitions = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+    }
+    else
+    {
+      std::fprintf(stderr, "usage: %s [--filter SUBSTRING] [--items N] [--repetitions N] [--json FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+  suite s(opts);
+  run_fields(s);
+  run_mixed(s);
+  run_stats_overhead(s);
+  run_dispatch<2>(s);
+  run_dispatch<8>(s);
+  run_dispatch<32>(s);
+  run_dispatch<128>(s);
+  return s.write_json()? 0 : 1;
+}
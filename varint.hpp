@@ -0,0 +1,360 @@
+#ifndef varint_hpp_20201010_162254_PDT
+#define varint_hpp_20201010_162254_PDT
+
+#include "field.hpp"
+#include <string>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <cpp/cpp.hpp>
+#include <cpp/type_traits.hpp>
+
+namespace tpl {
+/*!
+ * \brief An unsigned integer `Message` field which is encoded as an LEB128 varint: seven bits per byte, least
+ *        significant group first, with the high bit of each byte set if another byte follows.  Small values thereby
+ *        take a single byte regardless of `T`.
+ */
+template<typename T>
+class varint
+{
+  static_assert(cpp::is_integral<T>::value && std::is_unsigned<T>::value, "varint requires an unsigned integral type; use zigzag for signed types.");
+public:
+  using value_type = T;
+
+  constexpr varint(T value = T())
+    : value_(value)
+    {}
+  constexpr operator T() const { return value_; }
+  constexpr auto value() const -> T { return value_; }
+
+  friend constexpr auto operator==(const varint& lhs, const varint& rhs) -> bool { return lhs.value_ == rhs.value_; }
+  friend constexpr auto operator!=(const varint& lhs, const varint& rhs) -> bool { return lhs.value_ != rhs.value_; }
+private:
+  T value_;
+};
+/*!
+ * \brief A signed integer `Message` field which is zigzag-mapped onto an unsigned integer (0, -1, 1, -2, ... become
+ *        0, 1, 2, 3, ...) and then encoded as a `varint`, so that values of small magnitude take a single byte.
+ */
+template<typename T>
+class zigzag
+{
+  static_assert(cpp::is_integral<T>::value && std::is_signed<T>::value, "zigzag requires a signed integral type; use varint for unsigned types.");
+public:
+  using value_type = T;
+
+  constexpr zigzag(T value = T())
+    : value_(value)
+    {}
+  constexpr operator T() const { return value_; }
+  constexpr auto value() const -> T { return value_; }
+
+  friend constexpr auto operator==(const zigzag& lhs, const zigzag& rhs) -> bool { return lhs.value_ == rhs.value_; }
+  friend constexpr auto operator!=(const zigzag& lhs, const zigzag& rhs) -> bool { return lhs.value_ != rhs.value_; }
+private:
+  T value_;
+};
+/*!
+ * \brief A string `Message` field whose length prefix is a `varint` rather than a full `size_t`; otherwise a
+ *        `cpp::string` in every respect.
+ */
+class compact_string : public cpp::string
+{
+public:
+  using cpp::string::string;
+  compact_string() = default;
+  compact_string(const cpp::string& s)
+    : cpp::string(s)
+    {}
+  compact_string(cpp::string&& s)
+    : cpp::string(cpp::move(s))
+    {}
+};
+
+namespace detail {
+  template<typename U>
+  struct varint_traits
+  {
+    static constexpr size_t max_size = (cpp::numeric_limits<U>::digits + 6) / 7;
+  };
+
+  template<typename U>
+  auto varint_size(U value) -> size_t
+    {
+      size_t size = 1;
+      while(value >= 0x80)
+      {
+        value >>= 7;
+        ++size;
+      }
+      return size;
+    }
+
+  template<typename U>
+  auto encode_varint(char*& out, U value) -> void
+    {
+      while(value >= 0x80)
+      {
+        *out++ = static_cast<char>(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+      }
+      *out++ = static_cast<char>(value);
+    }
+
+  template<typename U>
+  auto decode_varint_bytewise(const char*& begin, const char* end) -> U
+    {
+      U        result = 0;
+      unsigned shift  = 0;
+      for(size_t i = 0; ; ++i)
+      {
+        if(begin >= end)
+        {
+          detail::throw_error<std::length_error>("read past end");
+        }
+        if(i == varint_traits<U>::max_size)
+        {
+          detail::throw_error<std::overflow_error>("varint too long for field type");
+        }
+        auto byte = static_cast<uint8_t>(*begin++);
+        result |= static_cast<U>(static_cast<U>(byte & 0x7F) << shift);
+        if((byte & 0x80) == 0)
+        {
+          return result;
+        }
+        shift += 7;
+      }
+    }
+
+  /*!
+   * \brief Decodes a varint of up to 8 bytes (56 bits of payload) without a per-byte loop, when at least 8 bytes of
+   *        input remain: the terminating byte is found with one bit scan over a 64-bit load, and the 7-bit groups are
+   *        packed together with three mask-and-shift steps.  Longer varints, and the tail of the input, take the
+   *        bytewise path.
+   */
+  template<typename U>
+  auto decode_varint(const char*& begin, const char* end) -> U
+    {
+#if defined(__GNUC__)
+      if(host_endianness != endianness::unknown && end - begin >= 8)
+      {
+        uint64_t word;
+        std::memcpy(&word, begin, sizeof(word));
+        if(host_endianness == endianness::big)
+        {
+          word = byte_swap(word);
+        }
+        auto stop = ~word & UINT64_C(0x8080808080808080);
+        if(stop != 0)
+        {
+          auto size = static_cast<size_t>(__builtin_ctzll(stop)) / 8 + 1;
+          if(size > varint_traits<U>::max_size)
+          {
+            detail::throw_error<std::overflow_error>("varint too long for field type");
+          }
+          if(size < 8)
+          {
+            word &= (UINT64_C(1) << (size * 8)) - 1;
+          }
+          word &= UINT64_C(0x7F7F7F7F7F7F7F7F);
+          word = ((word & UINT64_C(0x7F007F007F007F00)) >> 1) | (word & UINT64_C(0x007F007F007F007F));
+          word = ((word & UINT64_C(0x3FFF00003FFF0000)) >> 2) | (word & UINT64_C(0x00003FFF00003FFF));
+          word = ((word & UINT64_C(0x0FFFFFFF00000000)) >> 4) | (word & UINT64_C(0x000000000FFFFFFF));
+          begin += size;
+          return static_cast<U>(word);
+        }
+      }
+#endif
+      return decode_varint_bytewise<U>(begin, end);
+    }
+
+  /*!
+   * \brief Same contract as `Field::skip`, for a varint which must decode to a value no greater than `max`--as
+   *        `Field<varint<T>>::deserialize` requires, so that a varint which skips also decodes.
+   */
+  inline auto skip_varint(const char*& begin, const char* end, uint64_t max) -> size_t
+    {
+      uint64_t value = 0;
+      unsigned shift = 0;
+      for(auto p = begin; p < end; ++p)
+      {
+        if(p - begin == static_cast<std::ptrdiff_t>(varint_traits<uint64_t>::max_size))
+        {
+          return skip_invalid;
+        }
+        auto byte = static_cast<uint8_t>(*p);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+        {
+          if(value > max)
+          {
+            return skip_invalid;
+          }
+          begin = p + 1;
+          return 0;
+        }
+        shift += 7;
+      }
+      return 1;
+    }
+} /* namespace detail */
+
+/*!
+ * \brief LEB128 varint Field objects.
+ */
+template<typename T>
+class Field<varint<T>>
+{
+  using string_iter = cpp::string::const_iterator;
+public:
+  using value_type = varint<T>;
+
+  static constexpr bool   is_fixed_width = false;
+  static constexpr size_t fixed_size     = 0;
+
+  static auto serialized_size(const value_type& value) -> size_t
+    {
+      return detail::varint_size(value.value());
+    }
+  static auto serialize(char*& out, const value_type& value) -> void
+    {
+      detail::encode_varint(out, value.value());
+    }
+  static auto serialize(cpp::string& s, const value_type& value) -> void
+    {
+      detail::append_serialized<Field>(s, value);
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> value_type
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_varint(begin, end, cpp::numeric_limits<T>::max());
+    }
+  static auto deserialize(const char*& begin, const char* end) -> value_type
+    {
+      auto p     = begin;
+      auto value = detail::decode_varint<uint64_t>(p, end);
+      if(value > cpp::numeric_limits<T>::max())
+      {
+        detail::throw_error<std::overflow_error>("varint too long for field type");
+      }
+      begin = p;
+      return static_cast<T>(value);
+    }
+};
+/*!
+ * \brief Zigzag varint Field objects.
+ */
+template<typename T>
+class Field<zigzag<T>>
+{
+  using string_iter   = cpp::string::const_iterator;
+  using unsigned_type = cpp::make_unsigned_t<T>;
+  using varint_field  = Field<varint<unsigned_type>>;
+
+  static auto encode(T value) -> unsigned_type
+    {
+      return (static_cast<unsigned_type>(value) << 1) ^ static_cast<unsigned_type>(value < 0? -1 : 0);
+    }
+  static auto decode(unsigned_type value) -> T
+    {
+      return static_cast<T>((value >> 1) ^ (~(value & 1) + 1));
+    }
+public:
+  using value_type = zigzag<T>;
+
+  static constexpr bool   is_fixed_width = false;
+  static constexpr size_t fixed_size     = 0;
+
+  static auto serialized_size(const value_type& value) -> size_t
+    {
+      return varint_field::serialized_size(encode(value.value()));
+    }
+  static auto serialize(char*& out, const value_type& value) -> void
+    {
+      varint_field::serialize(out, encode(value.value()));
+    }
+  static auto serialize(cpp::string& s, const value_type& value) -> void
+    {
+      detail::append_serialized<Field>(s, value);
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> value_type
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return varint_field::skip(begin, end);
+    }
+  static auto deserialize(const char*& begin, const char* end) -> value_type
+    {
+      return decode(varint_field::deserialize(begin, end).value());
+    }
+};
+/*!
+ * \brief Compact string Field objects; as `cpp::string`, but with a `varint` length prefix.
+ */
+template<>
+class Field<compact_string>
+{
+  using string_iter = cpp::string::const_iterator;
+  using size_field  = Field<varint<cpp::string::size_type>>;
+public:
+  using value_type = compact_string;
+
+  static constexpr bool   is_fixed_width = false;
+  static constexpr size_t fixed_size     = 0;
+
+  static auto serialized_size(const compact_string& source) -> size_t
+    {
+      return size_field::serialized_size(source.size()) + source.size();
+    }
+  static auto serialize(char*& out, const compact_string& source) -> void
+    {
+      size_field::serialize(out, source.size());
+      out += source.copy(out, source.size());
+    }
+  template<typename GatherT>
+  static auto serialize_gather(GatherT& out, const compact_string& source) -> void
+    {
+      auto p = out.prepare(size_field::serialized_size(source.size()));
+      size_field::serialize(p, source.size());
+      out.reference(source.data(), source.size());
+    }
+  static auto serialize(cpp::string& s, const compact_string& source) -> void
+    {
+      detail::append_serialized<Field>(s, source);
+    }
+  static auto deserialize(string_iter& begin, const string_iter& end) -> compact_string
+    {
+      return detail::deserialize_from<Field>(begin, end);
+    }
+  static auto skip(const char*& begin, const char* end) -> size_t
+    {
+      return detail::skip_length_prefixed<size_field>(begin, end);
+    }
+  static auto deserialize(const char*& begin, const char* end) -> compact_string
+    {
+      compact_string result;
+      deserialize(begin, end, result);
+      return result;
+    }
+  static auto deserialize(const char*& begin, const char* end, compact_string& target) -> void
+    {
+      size_t size = size_field::deserialize(begin, end);
+      if(static_cast<size_t>(end - begin) < size)
+      {
+        detail::throw_error<std::length_error>("encoded string length greater than remaining stream length");
+      }
+      target.assign(begin, size);
+      begin += size;
+    }
+};
+} /* namespace tpl */
+
+#endif//varint_hpp_20201010_162254_PDT